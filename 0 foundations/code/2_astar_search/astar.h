@@ -0,0 +1,1029 @@
+#ifndef ASTAR_H
+#define ASTAR_H
+
+#include <algorithm>  // for sort, push_heap, pop_heap, fill, reverse
+#include <atomic>
+#include <chrono>
+#include <climits>  // for INT_MAX, INT_MIN
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <type_traits>  // for is_same
+#include <vector>
+
+// TODO: Add kStart and kFinish enumerators to the State enum.
+enum class State {kEmpty, kObstacle, kClosed, kPath, kStart, kFinish};
+
+// directional deltas
+const int delta[4][2]{{-1, 0}, {0, -1}, {1, 0}, {0, 1}};
+
+
+// A cell on the board, used for search results.
+struct Point {
+  int x;
+  int y;
+
+  bool operator==(const Point &other) const { return x == other.x && y == other.y; }
+  bool operator!=(const Point &other) const { return !(*this == other); }
+};
+
+
+/**
+ * Open list entry. Plain struct so pushing and comparing nodes never allocates.
+ */
+struct Node {
+  int x;
+  int y;
+  int g;
+  int h;
+
+  bool operator==(const Node &other) const {
+    return x == other.x && y == other.y && g == other.g && h == other.h;
+  }
+  bool operator!=(const Node &other) const { return !(*this == other); }
+};
+
+
+/**
+ * Board stored in one row-major buffer instead of a vector per row.
+ * grid(x, y) is row x, column y, same as grid[x][y] on a nested vector.
+ * Revision() goes up on every write to a cell, AddRow and assignment, so
+ * anything cached from the board can tell it was edited. On a non-const
+ * Grid, grid(x, y) gives a CellRef so that writing through it goes through
+ * Set too; reads never move the revision. A copy carries its source's
+ * revision, since it holds the same cells. A Grid moved from is left empty
+ * with its revision moved on. Nothing here is synchronized, so edits must
+ * not overlap readers in other threads.
+ */
+class Grid {
+  public:
+    Grid() : height(0), width(0), revision(0) {}
+    Grid(int h, int w, State fill = State::kEmpty) : height(h), width(w), cells(h * w, fill), revision(0) {}
+    Grid(const std::vector<std::vector<State>> &rows) : Grid() {
+      for (auto &row : rows)
+        AddRow(row);
+    }
+    Grid(const Grid &) = default;
+    Grid(Grid &&other)
+        : height(other.height), width(other.width), cells(std::move(other.cells)), revision(other.revision) {
+      other.Clear();
+    }
+
+    Grid &operator=(const Grid &other) {
+      uint64_t next = std::max(revision, other.revision) + 1;
+      height = other.height;
+      width = other.width;
+      cells = other.cells;
+      revision = next;
+      return *this;
+    }
+    Grid &operator=(Grid &&other) {
+      uint64_t next = std::max(revision, other.revision) + 1;
+      height = other.height;
+      width = other.width;
+      cells = std::move(other.cells);
+      revision = next;
+      if (&other != this)
+        other.Clear();
+      return *this;
+    }
+
+    // One cell of a non-const Grid: reads as its State, writes call Set.
+    class CellRef {
+      public:
+        CellRef(Grid &grid, int x, int y) : grid(grid), x(x), y(y) {}
+        operator State() const { return grid.cells[grid.Index(x, y)]; }
+        CellRef &operator=(State state) {
+          grid.Set(x, y, state);
+          return *this;
+        }
+        CellRef &operator=(const CellRef &other) { return *this = State(other); }
+
+      private:
+        Grid &grid;
+        int x;
+        int y;
+    };
+
+    int Height() const { return height; }
+    int Width() const { return width; }
+    int Size() const { return cells.size(); }
+    bool Empty() const { return cells.empty(); }
+
+    // Position of cell (x, y) in the row-major buffer.
+    int Index(int x, int y) const { return x * width + y; }
+
+    CellRef operator()(int x, int y) { return CellRef(*this, x, y); }
+    const State &operator()(int x, int y) const { return cells[x * width + y]; }
+
+    // Edit cell (x, y), moving the revision on.
+    void Set(int x, int y, State state) {
+      revision++;
+      cells[x * width + y] = state;
+    }
+
+    uint64_t Revision() const { return revision; }
+
+    // Append a row, the first row sets the width of the board.
+    void AddRow(const std::vector<State> &row) {
+      revision++;
+      if (height == 0)
+        width = row.size();
+      cells.insert(cells.end(), row.begin(), row.end());
+      cells.resize((height + 1) * width, State::kObstacle);
+      height++;
+    }
+
+    bool operator==(const Grid &other) const {
+      return height == other.height && width == other.width && cells == other.cells;
+    }
+    bool operator!=(const Grid &other) const { return !(*this == other); }
+
+  private:
+    int height;
+    int width;
+    std::vector<State> cells;
+    uint64_t revision;
+
+    void Clear() {
+      height = 0;
+      width = 0;
+      cells.clear();
+      revision++;
+    }
+};
+
+
+inline std::vector<State> ParseLine(std::string line) {
+    std::istringstream sline(line);
+    int n;
+    char c;
+    std::vector<State> row;
+    while (sline >> n >> c && c == ',') {
+      if (n == 0) {
+        row.push_back(State::kEmpty);
+      } else {
+        row.push_back(State::kObstacle);
+      }
+    }
+    return row;
+}
+
+
+inline Grid ReadBoardFile(std::string path) {
+  std::ifstream myfile (path);
+  Grid board{};
+  if (myfile) {
+    std::string line;
+    while (getline(myfile, line)) {
+      board.AddRow(ParseLine(line));
+    }
+  }
+  return board;
+}
+
+
+/**
+ * Compare the F values of two cells.
+ * Ties are broken on h so that cells closer to the goal come out first.
+ */
+inline bool Compare(const Node &a, const Node &b) {
+  int f1 = a.g + a.h; // f1 = g1 + h1
+  int f2 = b.g + b.h; // f2 = g2 + h2
+  if (f1 != f2)
+    return f1 > f2;
+  return a.h > b.h;
+}
+
+
+/**
+ * Sort the vector of nodes in descending order.
+ */
+inline void CellSort(std::vector<Node> *v) {
+  std::sort(v->begin(), v->end(), Compare);
+}
+
+
+// Calculate the manhattan distance
+inline int Heuristic(int x1, int y1, int x2, int y2) {
+  return std::abs(x2 - x1) + std::abs(y2 - y1);
+}
+
+
+/** 
+ * Check that a cell is valid: on the grid, not an obstacle, and clear. 
+ */
+inline bool CheckValidCell(int x, int y, const Grid &grid) {
+  bool on_grid_x = (x >= 0 && x < grid.Height());
+  bool on_grid_y = (y >= 0 && y < grid.Width());
+  if (on_grid_x && on_grid_y)
+    return grid(x, y) == State::kEmpty;
+  return false;
+}
+
+
+/** 
+ * Add a node to the open list and mark it as open. 
+ * The open list is kept as a binary min-heap on f, so this is O(log n).
+ */
+inline void AddToOpen(int x, int y, int g, int h, std::vector<Node> &openlist, Grid &grid) {
+  // Add node to open vector, and mark grid cell as closed (visited)
+  openlist.push_back(Node{x, y, g, h});
+  std::push_heap(openlist.begin(), openlist.end(), Compare);
+  grid(x, y) = State::kClosed;
+}
+
+
+/** 
+ * Remove and return the node with the lowest f value from the open list. 
+ */
+inline Node PopFromOpen(std::vector<Node> &openlist) {
+  // Heap front has lowest f value, pop_heap moves it to the back
+  std::pop_heap(openlist.begin(), openlist.end(), Compare);
+  Node current = openlist.back();
+  openlist.pop_back();
+  return current;
+}
+
+
+/** 
+ * Expand current nodes's neighbors and add them to the open list.
+ */
+inline void ExpandNeighbors(const Node &current, int goal[2], std::vector<Node> &openlist, Grid &grid) {
+  // Get current node's data.
+  int x = current.x;
+  int y = current.y;
+  int g = current.g;
+
+  // Loop through current node's potential neighbors.
+  for (int i = 0; i < 4; i++) {
+    int x2 = x + delta[i][0];
+    int y2 = y + delta[i][1];
+
+    // Check that the potential neighbor's x2 and y2 values are on the grid and not closed.
+    if (CheckValidCell(x2, y2, grid)) {
+      // Increment g value and add neighbor to open list.
+      int g2 = g + 1;
+      int h2 = Heuristic(x2, y2, goal[0], goal[1]);
+      AddToOpen(x2, y2, g2, h2, openlist, grid);
+    }
+  }
+}
+
+
+/**
+ * Neighborhood policies for SearchContext. Each one fixes at compile time
+ * which moves are allowed, what they cost and the matching heuristic, so the
+ * neighbor loop of each variant has a constant trip count and no branches on
+ * topology. Heuristic is the exact cost on an empty board, which keeps it
+ * admissible and consistent.
+ */
+constexpr int AbsDiff(int a, int b) { return a > b ? a - b : b - a; }
+
+// Up, left, down, right at cost 1 with the Manhattan heuristic.
+struct FourConnected {
+  static constexpr int kDirections = 4;
+  static constexpr int kDelta[4][2]{{-1, 0}, {0, -1}, {1, 0}, {0, 1}};
+  static constexpr int kCost[4]{1, 1, 1, 1};
+  static constexpr bool kCutCorners = true;
+
+  static constexpr int Heuristic(int x1, int y1, int x2, int y2) {
+    return AbsDiff(x1, x2) + AbsDiff(y1, y2);
+  }
+};
+
+/**
+ * The four straight moves at cost 10 plus the diagonals at cost 14, about
+ * 10 * sqrt(2), with the octile heuristic. A diagonal move only needs its
+ * target cell to be open, so it may pass between two obstacles.
+ */
+struct EightConnected {
+  static constexpr int kDirections = 8;
+  static constexpr int kDelta[8][2]{{-1, 0}, {0, -1}, {1, 0}, {0, 1}, {-1, -1}, {-1, 1}, {1, -1}, {1, 1}};
+  static constexpr int kCost[8]{10, 10, 10, 10, 14, 14, 14, 14};
+  static constexpr bool kCutCorners = true;
+
+  static constexpr int Heuristic(int x1, int y1, int x2, int y2) {
+    int dx = AbsDiff(x1, x2);
+    int dy = AbsDiff(y1, y2);
+    return dx < dy ? 14 * dx + 10 * (dy - dx) : 14 * dy + 10 * (dx - dy);
+  }
+};
+
+// EightConnected, but a diagonal move also needs both cells beside it open.
+struct EightConnectedNoCorners : EightConnected {
+  static constexpr bool kCutCorners = false;
+};
+
+
+/**
+ * How SearchContext generates successors.
+ * kNeighbors pushes every open neighbor. kJumpPoints runs Jump Point Search:
+ * it skips over straight runs of cells that have only one sensible way
+ * through, and pushes only the cells where the path may have to turn.
+ * Jump points are only worked out for FourConnected, other neighborhoods
+ * always expand plain neighbors. The first kJumpPoints query on a board, and
+ * the first after it changes, builds jump tables in O(W*H); after that every
+ * jump costs O(1) plus the goal columns it passes.
+ */
+enum class Expansion {kNeighbors, kJumpPoints};
+
+
+/**
+ * Per-query counters for BasicSearchContext, filled in when it is
+ * instantiated with Stats = SearchStats. The context calls the hooks at each
+ * event; NoStats has the same hooks as empty inline functions, so a context
+ * without stats compiles to the same code as one that never had them.
+ * Add stats of many queries with +=.
+ */
+struct SearchStats {
+  long long expanded = 0;          // cells taken off the open list and expanded
+  long long pushed = 0;            // open list insertions
+  long long duplicate_pushes = 0;  // insertions of a cell already queued
+  size_t peak_open = 0;            // most entries on the open list at once
+  long long heuristic_calls = 0;
+  long long scanned = 0;           // cells jumped over by Jump Point Search
+  double seconds = 0;              // wall time spent in Search
+  int queries = 0;
+
+  void Begin() {
+    *this = SearchStats{};
+    queries = 1;
+    start = std::chrono::steady_clock::now();
+  }
+  void End() { seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count(); }
+  void Expand() { expanded++; }
+  void Push(bool duplicate, size_t open_size) {
+    pushed++;
+    duplicate_pushes += duplicate;
+    peak_open = std::max(peak_open, open_size);
+  }
+  void HeuristicCall() { heuristic_calls++; }
+  void Scan(long long cells) { scanned += cells; }
+
+  SearchStats &operator+=(const SearchStats &other) {
+    expanded += other.expanded;
+    pushed += other.pushed;
+    duplicate_pushes += other.duplicate_pushes;
+    peak_open = std::max(peak_open, other.peak_open);
+    heuristic_calls += other.heuristic_calls;
+    scanned += other.scanned;
+    seconds += other.seconds;
+    queries += other.queries;
+    return *this;
+  }
+
+  private:
+    std::chrono::steady_clock::time_point start;
+};
+
+struct NoStats {
+  void Begin() {}
+  void End() {}
+  void Expand() {}
+  void Push(bool, size_t) {}
+  void HeuristicCall() {}
+  void Scan(long long) {}
+};
+
+
+/**
+ * Per-cell scratch state of one A* search, shared by the search contexts.
+ * The arrays are stamped with a generation counter: a cell's g value and
+ * parent only count if its stamp matches the current query, so starting a
+ * new query is O(1) instead of clearing every cell.
+ */
+struct SearchScratch {
+  std::vector<unsigned> seen;    // generation in which g_score/parent were set
+  std::vector<unsigned> closed;  // generation in which the cell was expanded
+  std::vector<int> g_score;
+  std::vector<int> parent;       // index of the previous cell on the path, -1 at the start
+  unsigned generation;
+
+  SearchScratch(int size = 0) : seen(size, 0), closed(size, 0), g_score(size, 0), parent(size, -1), generation(0) {}
+
+  // Start a new query: every cell reads as unseen and open again.
+  void NextGeneration() {
+    generation++;
+    // Stamps wrapped around, old values could look current again.
+    if (generation == 0) {
+      std::fill(seen.begin(), seen.end(), 0);
+      std::fill(closed.begin(), closed.end(), 0);
+      generation = 1;
+    }
+  }
+
+  bool Seen(int i) const { return seen[i] == generation; }
+  bool Closed(int i) const { return closed[i] == generation; }
+  void Close(int i) { closed[i] = generation; }
+
+  // Reach cell i with cost g from cell from.
+  void Record(int i, int g, int from) {
+    seen[i] = generation;
+    g_score[i] = g;
+    parent[i] = from;
+  }
+
+  // True unless cell i is closed or already reached at cost g or less.
+  bool Improves(int i, int g) const { return !Closed(i) && !(Seen(i) && g_score[i] <= g); }
+
+  size_t Bytes() const {
+    return (seen.size() + closed.size()) * sizeof(unsigned) + (g_score.size() + parent.size()) * sizeof(int);
+  }
+};
+
+
+/**
+ * Reusable A* state for many queries against one board.
+ * The board is only read, never marked, so it is not copied per query. The
+ * per-cell state is a SearchScratch, so starting a new query is O(1) instead
+ * of clearing W*H cells. The board must outlive the context.
+ * Neighborhood picks the moves and heuristic, see FourConnected. Stats is
+ * SearchStats to count what each query does, see LastStats(). HeuristicPolicy
+ * replaces the neighborhood's heuristic: anything with a consistent
+ * Heuristic(x, y, goal_x, goal_y) in the neighborhood's units, such as
+ * LandmarkHeuristic.
+ */
+template <typename Neighborhood, typename Stats = NoStats, typename HeuristicPolicy = Neighborhood>
+class BasicSearchContext {
+  public:
+    BasicSearchContext(const Grid &board, HeuristicPolicy heuristic = HeuristicPolicy())
+        : board(board), heuristic(heuristic), scratch(board.Size()), runs_revision(0) {}
+
+    const Grid &Board() const { return board; }
+
+    // Counters for the last call to Search.
+    const Stats &LastStats() const { return stats; }
+
+    // Bytes of per-cell search state, not counting the open list.
+    size_t Bytes() const {
+      size_t bytes = scratch.Bytes() + goal_bits.size() / 8;
+      for (auto &r : runs)
+        bytes += r.size() * sizeof(int);
+      return bytes;
+    }
+
+    /**
+     * Find a cheapest path from init to goal under the Neighborhood's costs.
+     * Returns the cells on the path from init to goal inclusive, or an empty
+     * vector if goal can't be reached. Both expansion modes give paths of the
+     * same length, though not always the same cells.
+     */
+    std::vector<Point> Search(int init[2], int goal[2], Expansion mode = Expansion::kNeighbors) {
+      stats.Begin();
+      std::vector<Point> path{};
+      if (Passable(goal[0], goal[1]))
+        path = Run(init, OneGoal{goal[0], goal[1], heuristic}, mode);
+      stats.End();
+      return path;
+    }
+
+    std::vector<Point> Search(Point init, Point goal, Expansion mode = Expansion::kNeighbors) {
+      int i[2]{init.x, init.y};
+      int g[2]{goal.x, goal.y};
+      return Search(i, g, mode);
+    }
+
+    /**
+     * Find a cheapest path from init to whichever of goals is nearest, in one
+     * search: the heuristic is the lowest over all goals, which is still
+     * consistent, so the first goal taken off the open list is the nearest
+     * one. Returns an empty vector if no goal can be reached. Each heuristic
+     * call looks at every goal, so this pays off for a handful of goals
+     * rather than thousands. Goal tests are one bit lookup, the bits being
+     * set for this query's goals and cleared again before returning.
+     */
+    std::vector<Point> SearchNearest(Point init, const std::vector<Point> &goals,
+                                     Expansion mode = Expansion::kNeighbors) {
+      stats.Begin();
+      if (goal_bits.size() != size_t(board.Size()))
+        goal_bits.assign(board.Size(), false);
+      goal_cells.clear();
+      for (auto &goal : goals) {
+        if (!Passable(goal.x, goal.y) || goal_bits[board.Index(goal.x, goal.y)])
+          continue;
+        goal_bits[board.Index(goal.x, goal.y)] = true;
+        goal_cells.push_back(goal);
+      }
+      std::sort(goal_cells.begin(), goal_cells.end(), AnyGoal::ColumnMajor);
+      int i[2]{init.x, init.y};
+      std::vector<Point> path = Run(i, AnyGoal{goal_cells, goal_bits, board.Width(), heuristic}, mode);
+      for (auto &goal : goal_cells)
+        goal_bits[board.Index(goal.x, goal.y)] = false;
+      stats.End();
+      return path;
+    }
+
+  private:
+    /**
+     * Goal tests and heuristics for Run. Jump also asks for the next goal
+     * column after from in direction dy (-1 if none), and for the steps from
+     * row from to the nearest goal in a column in direction dx (0 if none
+     * within steps).
+     */
+    struct OneGoal {
+      int x;
+      int y;
+      const HeuristicPolicy &policy;
+
+      bool Empty() const { return false; }
+      bool Contains(int x2, int y2) const { return x2 == x && y2 == y; }
+      int Heuristic(int x2, int y2) const { return policy.Heuristic(x2, y2, x, y); }
+      int NextColumn(int from, int dy) const { return (y - from) * dy > 0 ? y : -1; }
+      int NearestInColumn(int column, int from, int dx, int steps) const {
+        int k = (x - from) * dx;
+        return column == y && k > 0 && k <= steps ? k : 0;
+      }
+    };
+
+    // cells must be sorted with ColumnMajor.
+    struct AnyGoal {
+      const std::vector<Point> &cells;  // sorted ColumnMajor
+      const std::vector<bool> &bits;    // set at the board index of each goal
+      int width;
+      const HeuristicPolicy &policy;
+
+      static bool ColumnMajor(const Point &a, const Point &b) { return a.y < b.y || (a.y == b.y && a.x < b.x); }
+
+      bool Empty() const { return cells.empty(); }
+      bool Contains(int x2, int y2) const { return bits[x2 * width + y2]; }
+      int NextColumn(int from, int dy) const {
+        if (dy > 0) {
+          auto it = std::upper_bound(cells.begin(), cells.end(), Point{INT_MAX, from}, ColumnMajor);
+          return it == cells.end() ? -1 : it->y;
+        }
+        auto it = std::lower_bound(cells.begin(), cells.end(), Point{INT_MIN, from}, ColumnMajor);
+        return it == cells.begin() ? -1 : (it - 1)->y;
+      }
+      int NearestInColumn(int column, int from, int dx, int steps) const {
+        if (dx > 0) {
+          auto it = std::upper_bound(cells.begin(), cells.end(), Point{from, column}, ColumnMajor);
+          return it != cells.end() && it->y == column && it->x - from <= steps ? it->x - from : 0;
+        }
+        auto it = std::lower_bound(cells.begin(), cells.end(), Point{from, column}, ColumnMajor);
+        return it != cells.begin() && (it - 1)->y == column && from - (it - 1)->x <= steps ? from - (it - 1)->x : 0;
+      }
+      int Heuristic(int x2, int y2) const {
+        int h = policy.Heuristic(x2, y2, cells[0].x, cells[0].y);
+        for (size_t k = 1; k < cells.size(); k++)
+          h = std::min(h, policy.Heuristic(x2, y2, cells[k].x, cells[k].y));
+        return h;
+      }
+    };
+
+    const Grid &board;
+    HeuristicPolicy heuristic;
+    SearchScratch scratch;
+    std::vector<Node> open;
+    Stats stats;
+    std::vector<Point> goal_cells;  // SearchNearest's goals, sorted for AnyGoal
+    std::vector<bool> goal_bits;  // SearchNearest's goals by board index
+    std::vector<int> runs[4];  // jump tables, see BuildJumpTables
+    uint64_t runs_revision;  // board revision the jump tables were built for
+
+    template <typename Goals>
+    std::vector<Point> Run(int init[2], const Goals &goal, Expansion mode) {
+      scratch.NextGeneration();
+      std::vector<Point> path{};
+      if (!Passable(init[0], init[1]) || goal.Empty())
+        return path;
+
+      bool jump = std::is_same<Neighborhood, FourConnected>::value && mode == Expansion::kJumpPoints;
+      if (jump && (runs_revision != board.Revision() || runs[0].size() != size_t(board.Size())))
+        BuildJumpTables();
+
+      open.clear();
+      Push(init[0], init[1], 0, -1, goal);
+
+      while (open.size() > 0) {
+        Node current = PopFromOpen(open);
+        int i = board.Index(current.x, current.y);
+        // Lazy deletion: a cell may sit in the heap more than once, only
+        // the first (cheapest) copy gets expanded.
+        if (scratch.Closed(i))
+          continue;
+        scratch.Close(i);
+        stats.Expand();
+
+        if (goal.Contains(current.x, current.y))
+          return BuildPath(i);
+
+        if (jump)
+          PushJumpPoints(current, i, goal);
+        else
+          PushNeighbors(current, i, goal);
+      }
+      return path;
+    }
+
+    bool Passable(int x, int y) const {
+      bool on_grid_x = (x >= 0 && x < board.Height());
+      bool on_grid_y = (y >= 0 && y < board.Width());
+      return on_grid_x && on_grid_y && board(x, y) != State::kObstacle;
+    }
+
+    // Push (x, y) unless it is closed or already queued with a lower g.
+    template <typename Goals>
+    void Relax(int x, int y, int g, int from, const Goals &goal) {
+      int i = board.Index(x, y);
+      if (scratch.Improves(i, g))
+        Push(x, y, g, from, goal);
+    }
+
+    template <typename Goals>
+    void PushNeighbors(const Node &current, int i, const Goals &goal) {
+      for (int d = 0; d < Neighborhood::kDirections; d++) {
+        int dx = Neighborhood::kDelta[d][0];
+        int dy = Neighborhood::kDelta[d][1];
+        int x2 = current.x + dx;
+        int y2 = current.y + dy;
+        if (!Passable(x2, y2))
+          continue;
+        if (!Neighborhood::kCutCorners && dx != 0 && dy != 0 &&
+            (!Passable(current.x + dx, current.y) || !Passable(current.x, current.y + dy)))
+          continue;
+        Relax(x2, y2, current.g + Neighborhood::kCost[d], i, goal);
+      }
+    }
+
+    /**
+     * Jump Point Search successors for a 4-connected grid.
+     * Among equally short paths we only follow the ones that make a
+     * horizontal move as early as possible. A horizontal run may turn
+     * vertical anywhere, but a vertical run only turns where an obstacle
+     * blocked the earlier horizontal move. The direction the current cell
+     * was entered from decides which jumps to try.
+     */
+    template <typename Goals>
+    void PushJumpPoints(const Node &current, int i, const Goals &goal) {
+      int x = current.x;
+      int y = current.y;
+      int from = scratch.parent[i];
+      if (from == -1) {
+        for (int d = 0; d < 4; d++)
+          TryJump(current, i, delta[d][0], delta[d][1], goal);
+        return;
+      }
+      int dx = Sign(x - from / board.Width());
+      int dy = Sign(y - from % board.Width());
+      if (dy != 0) {
+        TryJump(current, i, 0, dy, goal);
+        TryJump(current, i, 1, 0, goal);
+        TryJump(current, i, -1, 0, goal);
+      } else {
+        TryJump(current, i, dx, 0, goal);
+        for (int side = -1; side <= 1; side += 2) {
+          if (Passable(x, y + side) && !Passable(x - dx, y + side))
+            TryJump(current, i, 0, side, goal);
+        }
+      }
+    }
+
+    template <typename Goals>
+    void TryJump(const Node &current, int i, int dx, int dy, const Goals &goal) {
+      int x = current.x;
+      int y = current.y;
+      if (Jump(x, y, dx, dy, goal))
+        Relax(x, y, current.g + std::abs(x - current.x) + std::abs(y - current.y), i, goal);
+    }
+
+    /**
+     * Jump tables for FourConnected Jump Point Search. For an open cell i,
+     * runs[d][i] is k > 0 if a jump from i in direction delta[d] stops k
+     * steps away before any goal is considered, or -k if it runs into an
+     * obstacle or the edge after k open cells. A vertical run stops where a
+     * side opens up past an obstacle; a horizontal run stops where either
+     * vertical run from the cell would stop.
+     */
+    void BuildJumpTables() {
+      int h = board.Height();
+      int w = board.Width();
+      for (auto &r : runs)
+        r.assign(board.Size(), 0);
+      // Open cells with a blocked border around the board, so the sweeps
+      // below need no bounds checks.
+      int pw = w + 2;
+      std::vector<char> open_cells(size_t(h + 2) * pw, 0);
+      for (int x = 0; x < h; x++)
+        for (int y = 0; y < w; y++)
+          open_cells[size_t(x + 1) * pw + y + 1] = board(x, y) != State::kObstacle;
+      auto is_open = [&](int x, int y) { return open_cells[size_t(x + 1) * pw + y + 1] != 0; };
+      auto extend = [](int next, bool stop) { return stop ? 1 : next > 0 ? next + 1 : next - 1; };
+      auto vertical_stop = [&](int x, int y, int dx) {
+        return (is_open(x, y - 1) && !is_open(x - dx, y - 1)) || (is_open(x, y + 1) && !is_open(x - dx, y + 1));
+      };
+      // Row by row, so each sweep reads the board in memory order.
+      for (int x = 1; x < h; x++)
+        for (int y = 0; y < w; y++)
+          if (is_open(x - 1, y))
+            runs[0][board.Index(x, y)] = extend(runs[0][board.Index(x - 1, y)], vertical_stop(x - 1, y, -1));
+      for (int x = h - 2; x >= 0; x--)
+        for (int y = 0; y < w; y++)
+          if (is_open(x + 1, y))
+            runs[2][board.Index(x, y)] = extend(runs[2][board.Index(x + 1, y)], vertical_stop(x + 1, y, 1));
+      auto horizontal_stop = [&](int j) { return runs[0][j] > 0 || runs[2][j] > 0; };
+      for (int x = 0; x < h; x++) {
+        for (int y = 1; y < w; y++)
+          if (is_open(x, y - 1))
+            runs[1][board.Index(x, y)] = extend(runs[1][board.Index(x, y - 1)], horizontal_stop(board.Index(x, y - 1)));
+        for (int y = w - 2; y >= 0; y--)
+          if (is_open(x, y + 1))
+            runs[3][board.Index(x, y)] = extend(runs[3][board.Index(x, y + 1)], horizontal_stop(board.Index(x, y + 1)));
+      }
+      runs_revision = board.Revision();
+    }
+
+    /**
+     * Step from (x, y) in direction (dx, dy) until a jump point is found.
+     * Returns false if the run hits an obstacle or the edge first. On success
+     * (x, y) is moved to the jump point. The jump tables give where the run
+     * ends; only goals on the way have to be looked for. A vertical run stops
+     * at a goal in its column, a horizontal run at a column whose vertical
+     * runs reach a goal.
+     */
+    template <typename Goals>
+    bool Jump(int &x, int &y, int dx, int dy, const Goals &goal) {
+      int run = runs[Direction(dx, dy)][board.Index(x, y)];
+      int open_cells = std::abs(run);
+      int k = 0;
+      if (dx != 0) {
+        k = goal.NearestInColumn(y, x, dx, open_cells);
+      } else {
+        for (int c = goal.NextColumn(y, dy); c >= 0 && (c - y) * dy <= open_cells && k == 0;
+             c = goal.NextColumn(c, dy)) {
+          int j = board.Index(x, c);
+          if (goal.Contains(x, c) || goal.NearestInColumn(c, x, -1, std::abs(runs[0][j])) ||
+              goal.NearestInColumn(c, x, 1, std::abs(runs[2][j])))
+            k = std::abs(c - y);
+        }
+      }
+      if (k == 0 && run > 0)
+        k = run;
+      stats.Scan(k != 0 ? k : open_cells);
+      if (k == 0)
+        return false;
+      x += dx * k;
+      y += dy * k;
+      return true;
+    }
+
+    // Index into delta of the step (dx, dy).
+    static int Direction(int dx, int dy) { return dx < 0 ? 0 : dy < 0 ? 1 : dx > 0 ? 2 : 3; }
+
+    static int Sign(int v) { return (v > 0) - (v < 0); }
+
+    template <typename Goals>
+    void Push(int x, int y, int g, int from, const Goals &goal) {
+      int i = board.Index(x, y);
+      bool duplicate = scratch.Seen(i);
+      scratch.Record(i, g, from);
+      stats.HeuristicCall();
+      open.push_back(Node{x, y, g, goal.Heuristic(x, y)});
+      std::push_heap(open.begin(), open.end(), Compare);
+      stats.Push(duplicate, open.size());
+    }
+
+    // Walk parent links back from the goal cell, filling in the straight
+    // runs between jump points.
+    std::vector<Point> BuildPath(int goal_index) const {
+      std::vector<Point> path{};
+      int w = board.Width();
+      const std::vector<int> &parent = scratch.parent;
+      for (int i = goal_index; i != -1; i = parent[i]) {
+        Point p{i / w, i % w};
+        path.push_back(p);
+        if (parent[i] == -1)
+          break;
+        Point from{parent[i] / w, parent[i] % w};
+        int dx = Sign(from.x - p.x);
+        int dy = Sign(from.y - p.y);
+        for (p = Point{p.x + dx, p.y + dy}; p != from; p = Point{p.x + dx, p.y + dy})
+          path.push_back(p);
+      }
+      std::reverse(path.begin(), path.end());
+      return path;
+    }
+};
+
+typedef BasicSearchContext<FourConnected> SearchContext;
+
+
+/**
+ * Bidirectional A*: one search runs forward from init toward goal and one
+ * backward from goal toward init. Each step expands the side with the smaller
+ * open list. mu is the shortest init-goal path found so far through a cell
+ * reached from both sides. The lowest f on a side is a lower bound on any path
+ * through that side's open cells, so once either side's lowest f reaches mu
+ * no shorter path is left and mu is optimal.
+ * Each side has its own SearchScratch, so a context is reused across
+ * queries without clearing or reallocating them. The board must outlive
+ * the context.
+ */
+class BidirectionalSearchContext {
+  public:
+    BidirectionalSearchContext(const Grid &board) : board(board), scratch{board.Size(), board.Size()} {}
+
+    /**
+     * Find a shortest path from init to goal.
+     * Returns the cells on the path from init to goal inclusive, or an empty
+     * vector if goal can't be reached.
+     */
+    std::vector<Point> Search(int init[2], int goal[2]) {
+      std::vector<Point> path{};
+      if (!CheckValidCell(init[0], init[1], board) || !CheckValidCell(goal[0], goal[1], board))
+        return path;
+      for (auto &side : scratch)
+        side.NextGeneration();
+
+      // Side 0 searches forward from init, side 1 backward from goal.
+      int *start[2]{init, goal};
+      int *target[2]{goal, init};
+      for (int side = 0; side < 2; side++) {
+        int x = start[side][0];
+        int y = start[side][1];
+        scratch[side].Record(board.Index(x, y), 0, -1);
+        open[side].clear();
+        open[side].push_back(Node{x, y, 0, Heuristic(x, y, target[side][0], target[side][1])});
+      }
+
+      int mu = board.Index(init[0], init[1]) == board.Index(goal[0], goal[1]) ? 0 : -1;
+      int meet = mu == 0 ? board.Index(init[0], init[1]) : -1;
+      while (open[0].size() > 0 && open[1].size() > 0) {
+        if (mu != -1) {
+          int f0 = open[0].front().g + open[0].front().h;
+          int f1 = open[1].front().g + open[1].front().h;
+          if (f0 >= mu || f1 >= mu)
+            break;
+        }
+
+        int side = open[0].size() <= open[1].size() ? 0 : 1;
+        int other = 1 - side;
+        Node current = PopFromOpen(open[side]);
+        int i = board.Index(current.x, current.y);
+        if (scratch[side].Closed(i))
+          continue;
+        scratch[side].Close(i);
+
+        for (int d = 0; d < 4; d++) {
+          int x2 = current.x + delta[d][0];
+          int y2 = current.y + delta[d][1];
+          if (!CheckValidCell(x2, y2, board))
+            continue;
+          int j = board.Index(x2, y2);
+          int g2 = current.g + 1;
+          if (!scratch[side].Improves(j, g2))
+            continue;
+          scratch[side].Record(j, g2, i);
+          open[side].push_back(Node{x2, y2, g2, Heuristic(x2, y2, target[side][0], target[side][1])});
+          std::push_heap(open[side].begin(), open[side].end(), Compare);
+
+          // The other side has been here too: that's an init-goal path.
+          if (scratch[other].Seen(j) && (mu == -1 || g2 + scratch[other].g_score[j] < mu)) {
+            mu = g2 + scratch[other].g_score[j];
+            meet = j;
+          }
+        }
+      }
+      if (meet == -1)
+        return path;
+
+      int w = board.Width();
+      for (int i = meet; i != -1; i = scratch[0].parent[i])
+        path.push_back(Point{i / w, i % w});
+      std::reverse(path.begin(), path.end());
+      for (int i = scratch[1].parent[meet]; i != -1; i = scratch[1].parent[i])
+        path.push_back(Point{i / w, i % w});
+      return path;
+    }
+
+  private:
+    const Grid &board;
+    SearchScratch scratch[2];
+    std::vector<Node> open[2];
+};
+
+
+// One-off BidirectionalSearchContext query; keep a context for many queries.
+inline std::vector<Point> BidirectionalSearch(const Grid &grid, int init[2], int goal[2]) {
+  BidirectionalSearchContext context(grid);
+  return context.Search(init, goal);
+}
+
+
+// One (init, goal) pair for SearchBatch.
+struct Query {
+  Point init;
+  Point goal;
+  Expansion mode = Expansion::kNeighbors;
+};
+
+
+/**
+ * Run many queries against one board on a fixed number of worker threads.
+ * Each worker owns its SearchContext and only reads the shared board. Workers
+ * claim the next query from an atomic counter and write to their own result
+ * slot, so no locks are taken while searching. results[i] is the path for
+ * queries[i], empty if there is none. workers <= 0 uses one per core.
+ */
+inline std::vector<std::vector<Point>> SearchBatch(const Grid &board, const std::vector<Query> &queries, int workers = 0) {
+  std::vector<std::vector<Point>> results(queries.size());
+  if (workers <= 0)
+    workers = std::max(1u, std::thread::hardware_concurrency());
+  workers = std::min<int>(workers, queries.size());
+
+  std::atomic<size_t> next{0};
+  auto work = [&]() {
+    SearchContext context(board);
+    for (size_t i = next++; i < queries.size(); i = next++)
+      results[i] = context.Search(queries[i].init, queries[i].goal, queries[i].mode);
+  };
+
+  std::vector<std::thread> threads;
+  for (int i = 1; i < workers; i++)
+    threads.emplace_back(work);
+  // The calling thread works too instead of just waiting.
+  if (workers > 0)
+    work();
+  for (auto &t : threads)
+    t.join();
+  return results;
+}
+
+
+/**
+ * Mark a path on the grid: kStart at the first cell, kFinish at the last and
+ * kPath in between.
+ */
+inline void MarkPath(const std::vector<Point> &path, Grid &grid) {
+  for (auto &p : path)
+    grid(p.x, p.y) = State::kPath;
+  grid(path.front().x, path.front().y) = State::kStart;
+  grid(path.back().x, path.back().y) = State::kFinish;
+}
+
+
+/** 
+ * Implementation of A* search algorithm
+ * Returns the board with only the cells on the shortest path marked.
+ */
+inline Grid Search(Grid grid, int init[2], int goal[2]) {
+  SearchContext context(grid);
+  std::vector<Point> path = context.Search(init, goal);
+  if (path.empty()) {
+    // We've run out of new nodes to explore and haven't found a path.
+    std::cout << "No path found!" << "\n";
+    return Grid{};
+  }
+  MarkPath(path, grid);
+  return grid;
+}
+
+
+/**
+ * Compact path encoding: run-length encoded moves, e.g. "D4R3U1R2D1".
+ * U/D change x (row), L/R change y (column). The start cell is not included.
+ */
+inline std::string PathToDirections(const std::vector<Point> &path) {
+  std::string directions{};
+  char last = 0;
+  int run = 0;
+  for (size_t i = 1; i < path.size(); i++) {
+    int dx = path[i].x - path[i - 1].x;
+    int dy = path[i].y - path[i - 1].y;
+    char step = dx < 0 ? 'U' : dx > 0 ? 'D' : dy < 0 ? 'L' : 'R';
+    if (step != last && run > 0) {
+      directions += last + std::to_string(run);
+      run = 0;
+    }
+    last = step;
+    run++;
+  }
+  if (run > 0)
+    directions += last + std::to_string(run);
+  return directions;
+}
+
+
+/**
+ * Expand a string from PathToDirections back into the cells of the path.
+ */
+inline std::vector<Point> DirectionsToPath(Point start, const std::string &directions) {
+  std::vector<Point> path{start};
+  std::istringstream sdirections(directions);
+  char step;
+  int run;
+  while (sdirections >> step >> run) {
+    int dx = step == 'U' ? -1 : step == 'D' ? 1 : 0;
+    int dy = step == 'L' ? -1 : step == 'R' ? 1 : 0;
+    for (int i = 0; i < run; i++) {
+      Point last = path.back();
+      path.push_back(Point{last.x + dx, last.y + dy});
+    }
+  }
+  return path;
+}
+
+#endif
@@ -0,0 +1,200 @@
+#include <algorithm>
+#include <cstdlib>  // for atoi
+#include <iomanip>
+#include <iostream>
+#include <sys/resource.h>
+#include "astar.h"
+#include "board_gen.h"
+#include "cooperative.h"
+using std::cout;
+using std::istringstream;
+using std::string;
+using std::vector;
+
+// Benchmark SearchContext on generated boards.
+// Every board kind is run at every size from --min to --max, doubling, with a
+// fixed set of --queries random queries between open cells. Boards and
+// queries depend only on the size and --seed, so runs are comparable.
+// The default sweep goes up to 8192x8192, which peaks at about 1.3 GB and
+// takes minutes on the maze boards; --max 2048 gives a quick run.
+// Mnodes/s counts cells expanded plus, with --jps, cells jumped over.
+// With --agents N, CooperativePlanner is run instead, for 10, 100, ... up to
+// N agents with distinct starts and goals on every board.
+// Usage: benchmark [--min 64] [--max 8192] [--queries 50] [--seed 1] [--jps]
+//                  [--kinds open,random10,random30,maze,rooms] [--agents 1000]
+
+
+// Peak resident set size of this process so far, in MB.
+double PeakMemoryMB() {
+  struct rusage usage;
+  getrusage(RUSAGE_SELF, &usage);
+  return usage.ru_maxrss / 1024.0;
+}
+
+
+// Value at fraction p of the way through sorted.
+double Percentile(const vector<double> &sorted, double p) {
+  if (sorted.empty())
+    return 0;
+  return sorted[std::min(sorted.size() - 1, size_t(p * sorted.size()))];
+}
+
+
+// Pairs of open cells picked with their own generator.
+vector<Query> MakeQueries(const Grid &board, int count, unsigned seed, Expansion mode) {
+  std::mt19937 rng(seed);
+  vector<Point> open{};
+  for (int x = 0; x < board.Height(); x++)
+    for (int y = 0; y < board.Width(); y++)
+      if (board(x, y) != State::kObstacle)
+        open.push_back(Point{x, y});
+  vector<Query> queries{};
+  for (int i = 0; i < count && !open.empty(); i++)
+    queries.push_back(Query{open[rng() % open.size()], open[rng() % open.size()], mode});
+  return queries;
+}
+
+
+void RunBoard(const string &kind, int size, int query_count, unsigned seed, Expansion mode) {
+  Grid board = GenerateBoard(kind, size, size, seed);
+  if (board.Empty()) {
+    std::cerr << "Unknown board kind " << kind << "\n";
+    return;
+  }
+  vector<Query> queries = MakeQueries(board, query_count, seed, mode);
+  BasicSearchContext<FourConnected, SearchStats> context(board);
+  SearchStats total{};
+  vector<double> latencies{};
+  int found = 0;
+  for (auto &query : queries) {
+    auto path = context.Search(query.init, query.goal, query.mode);
+    latencies.push_back(context.LastStats().seconds * 1000);
+    total += context.LastStats();
+    found += !path.empty();
+  }
+  std::sort(latencies.begin(), latencies.end());
+
+  cout << std::left << std::setw(10) << kind << std::right << std::setw(6) << size
+       << std::setw(6) << found << "/" << std::left << std::setw(5) << queries.size() << std::right
+       << std::fixed << std::setprecision(3)
+       << std::setw(10) << Percentile(latencies, 0.5) << std::setw(10) << Percentile(latencies, 0.9)
+       << std::setw(10) << Percentile(latencies, 0.99) << std::setw(10) << (latencies.empty() ? 0 : latencies.back())
+       << std::setprecision(2) << std::setw(12)
+       << (total.seconds > 0 ? (total.expanded + total.scanned) / total.seconds / 1e6 : 0)
+       << std::setprecision(1) << std::setw(8) << (total.pushed > 0 ? 100.0 * total.duplicate_pushes / total.pushed : 0)
+       << std::setw(10) << total.peak_open
+       << std::setprecision(1) << std::setw(10) << PeakMemoryMB() << "\n";
+}
+
+
+// Plan count agents cooperatively, each with its own start and goal.
+void RunAgents(const Grid &board, const string &kind, int size, int count, unsigned seed) {
+  std::mt19937 rng(seed);
+  vector<Point> starts{};
+  for (int x = 0; x < board.Height(); x++)
+    for (int y = 0; y < board.Width(); y++)
+      if (board(x, y) != State::kObstacle)
+        starts.push_back(Point{x, y});
+  vector<Point> goals = starts;
+  std::shuffle(starts.begin(), starts.end(), rng);
+  std::shuffle(goals.begin(), goals.end(), rng);
+  vector<Query> queries{};
+  for (int a = 0; a < count && a < int(starts.size()); a++)
+    queries.push_back(Query{starts[a], goals[a]});
+
+  CooperativePlanner planner(board);
+  auto begin = std::chrono::steady_clock::now();
+  auto paths = planner.PlanAll(queries);
+  double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+  int planned = 0;
+  long long steps = 0;
+  size_t makespan = 0;
+  for (auto &path : paths) {
+    if (path.empty())
+      continue;
+    planned++;
+    steps += path.size() - 1;
+    makespan = std::max(makespan, path.size() - 1);
+  }
+
+  cout << std::left << std::setw(10) << kind << std::right << std::setw(6) << size
+       << std::setw(8) << queries.size() << std::setw(9) << planned
+       << std::fixed << std::setprecision(1) << std::setw(10) << seconds * 1000
+       << std::setw(10) << (seconds > 0 ? planned / seconds : 0)
+       << std::setw(10) << (planned > 0 ? double(steps) / planned : 0) << std::setw(10) << makespan
+       << std::setw(12) << (queries.empty() ? 0 : planner.Expanded() / queries.size())
+       << std::setw(12) << planner.Reservations().Size()
+       << std::setprecision(1) << std::setw(10) << PeakMemoryMB() << "\n";
+}
+
+
+int main(int argc, char *argv[]) {
+  int min_size = 64;
+  int max_size = 8192;
+  int query_count = 50;
+  unsigned seed = 1;
+  Expansion mode = Expansion::kNeighbors;
+  string kinds = "open,random10,random30,maze,rooms";
+  int agents = 0;
+  for (int i = 1; i < argc; i++) {
+    string arg = argv[i];
+    bool has_value = i + 1 < argc;
+    if (arg == "--min" && has_value)
+      min_size = std::atoi(argv[++i]);
+    else if (arg == "--max" && has_value)
+      max_size = std::atoi(argv[++i]);
+    else if (arg == "--queries" && has_value)
+      query_count = std::atoi(argv[++i]);
+    else if (arg == "--seed" && has_value)
+      seed = std::atoi(argv[++i]);
+    else if (arg == "--kinds" && has_value)
+      kinds = argv[++i];
+    else if (arg == "--agents" && has_value)
+      agents = std::atoi(argv[++i]);
+    else if (arg == "--jps")
+      mode = Expansion::kJumpPoints;
+    else {
+      std::cerr << "Usage: " << argv[0] << " [--min 64] [--max 8192] [--queries 50] [--seed 1] [--jps]"
+                << " [--kinds open,random10,random30,maze,rooms] [--agents 1000]" << "\n";
+      return 1;
+    }
+  }
+  if (min_size <= 0 || max_size < min_size) {
+    std::cerr << "Sizes must satisfy 0 < min <= max" << "\n";
+    return 1;
+  }
+
+  if (agents > 0) {
+    cout << std::left << std::setw(10) << "board" << std::right << std::setw(6) << "size"
+         << std::setw(8) << "agents" << std::setw(9) << "planned" << std::setw(10) << "ms"
+         << std::setw(10) << "planned/s" << std::setw(10) << "mean len" << std::setw(10) << "makespan"
+         << std::setw(12) << "expanded/a" << std::setw(12) << "reserved" << std::setw(10) << "peak MB" << "\n";
+    for (int size = min_size; size <= max_size; size *= 2) {
+      istringstream skinds(kinds);
+      string kind;
+      while (std::getline(skinds, kind, ',')) {
+        Grid board = GenerateBoard(kind, size, size, seed);
+        if (board.Empty()) {
+          std::cerr << "Unknown board kind " << kind << "\n";
+          continue;
+        }
+        for (int count = 10; count < agents * 10; count *= 10)
+          RunAgents(board, kind, size, std::min(count, agents), seed);
+      }
+    }
+    return 0;
+  }
+
+  cout << std::left << std::setw(10) << "board" << std::right << std::setw(6) << "size"
+       << std::setw(12) << "found" << std::setw(10) << "p50 ms" << std::setw(10) << "p90 ms"
+       << std::setw(10) << "p99 ms" << std::setw(10) << "max ms" << std::setw(12) << "Mnodes/s"
+       << std::setw(8) << "dup %" << std::setw(10) << "peak open"
+       << std::setw(10) << "peak MB" << "\n";
+  for (int size = min_size; size <= max_size; size *= 2) {
+    istringstream skinds(kinds);
+    string kind;
+    while (std::getline(skinds, kind, ','))
+      RunBoard(kind, size, query_count, seed, mode);
+  }
+  return 0;
+}
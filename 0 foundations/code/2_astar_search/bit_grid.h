@@ -0,0 +1,215 @@
+#ifndef BIT_GRID_H
+#define BIT_GRID_H
+
+#include <cstdint>
+#include <cstring>  // for memcpy
+#include "astar.h"
+#include "board_file.h"
+
+
+/**
+ * One bit per cell, with each row padded to whole 64-bit words. This is the
+ * same layout as the obstacle layer of a binary board file. Bit y % 64 of
+ * word y / 64 in row x is cell (x, y).
+ */
+class BitGrid {
+  public:
+    BitGrid() : height(0), width(0), row_words(0) {}
+    BitGrid(int h, int w) : height(h), width(w), row_words((w + 63) / 64), bits(size_t(h) * row_words, 0) {}
+
+    // Obstacle bits of a board.
+    explicit BitGrid(const Grid &board) : BitGrid(board.Height(), board.Width()) {
+      for (int x = 0; x < height; x++)
+        for (int y = 0; y < width; y++)
+          if (board(x, y) == State::kObstacle)
+            Set(x, y);
+    }
+
+    // Obstacle layer of a binary board file, copied word for word.
+    explicit BitGrid(const BinaryBoard &board) : BitGrid(board.Height(), board.Width()) {
+      for (int x = 0; x < height; x++)
+        std::memcpy(Row(x), board.ObstacleRow(x), row_words * 8);
+    }
+
+    int Height() const { return height; }
+    int Width() const { return width; }
+    int RowWords() const { return row_words; }
+    size_t Bytes() const { return bits.size() * 8; }
+
+    const uint64_t *Row(int x) const { return bits.data() + size_t(x) * row_words; }
+    uint64_t *Row(int x) { return bits.data() + size_t(x) * row_words; }
+
+    bool Test(int x, int y) const { return (Row(x)[y / 64] >> (y % 64)) & 1; }
+    void Set(int x, int y) { Row(x)[y / 64] |= uint64_t(1) << (y % 64); }
+    void Reset() { std::fill(bits.begin(), bits.end(), 0); }
+
+  private:
+    int height;
+    int width;
+    int row_words;
+    std::vector<uint64_t> bits;
+};
+
+
+/**
+ * Read-only view of obstacle bits in the BitGrid layout, either a BitGrid's
+ * own or the obstacle layer of a mapped BinaryBoard. Whatever it views must
+ * outlive it.
+ */
+class BitView {
+  public:
+    BitView(const BitGrid &grid)
+        : height(grid.Height()), width(grid.Width()), row_words(grid.RowWords()), bits(grid.Row(0)) {}
+    BitView(const BinaryBoard &board)
+        : height(board.Height()), width(board.Width()), row_words(board.Valid() ? board.RowWords() : 0),
+          bits(board.Valid() ? board.ObstacleRow(0) : nullptr) {}
+
+    int Height() const { return height; }
+    int Width() const { return width; }
+    int RowWords() const { return row_words; }
+
+    const uint64_t *Row(int x) const { return bits + size_t(x) * row_words; }
+    bool Test(int x, int y) const { return (Row(x)[y / 64] >> (y % 64)) & 1; }
+
+  private:
+    int height;
+    int width;
+    int row_words;
+    const uint64_t *bits;
+};
+
+
+/**
+ * A* over obstacle bits, for boards too big to keep as a Grid. It reads a
+ * BitGrid or a mapped BinaryBoard in place through a BitView.
+ * Per cell it keeps 1 obstacle bit, 1 closed bit and 2 bits for the direction
+ * the cell was entered from, 4 bits in all. Neighbours are checked by OR-ing
+ * obstacle and closed words and shifting out the bits around the cell.
+ * Open list entries carry their own g, so no per-cell g array is needed.
+ * Cells can be queued more than once, and only the first copy popped is
+ * expanded. The obstacles it views must outlive the context.
+ */
+class BitSearchContext {
+  public:
+    BitSearchContext(BitView obstacles)
+        : obstacles(obstacles), closed(obstacles.Height(), obstacles.Width()),
+          parent_dirs((size_t(obstacles.Height()) * obstacles.Width() + 3) / 4, 0) {}
+
+    /**
+     * Find a shortest path from init to goal.
+     * Returns the cells on the path from init to goal inclusive, or an empty
+     * vector if goal can't be reached.
+     */
+    std::vector<Point> Search(int init[2], int goal[2]) {
+      std::vector<Point> path{};
+      if (!OnBoard(init[0], init[1]) || !OnBoard(goal[0], goal[1]) ||
+          obstacles.Test(init[0], init[1]) || obstacles.Test(goal[0], goal[1]))
+        return path;
+
+      closed.Reset();
+      open.clear();
+      Push(Node{init[0], init[1], 0, Heuristic(init[0], init[1], goal[0], goal[1])}, 0);
+      while (open.size() > 0) {
+        std::pop_heap(open.begin(), open.end(), CompareEntries);
+        Entry current = open.back();
+        open.pop_back();
+        int x = current.node.x;
+        int y = current.node.y;
+        if (closed.Test(x, y))
+          continue;
+        closed.Set(x, y);
+        SetParentDir(x, y, current.dir);
+
+        if (x == goal[0] && y == goal[1])
+          return BuildPath(init, goal);
+
+        unsigned neighbors = OpenNeighbors(x, y);
+        for (int d = 0; d < 4; d++) {
+          if (!((neighbors >> d) & 1))
+            continue;
+          int x2 = x + delta[d][0];
+          int y2 = y + delta[d][1];
+          Push(Node{x2, y2, current.node.g + 1, Heuristic(x2, y2, goal[0], goal[1])}, d);
+        }
+      }
+      return path;
+    }
+
+    /**
+     * Bit d of the result is set if the neighbour at delta[d] is on the board,
+     * not an obstacle and not closed.
+     */
+    unsigned OpenNeighbors(int x, int y) const {
+      int word = y / 64;
+      int bit = y % 64;
+      unsigned result = 0;
+      // Up and down: the same bit in the rows above and below.
+      if (x > 0)
+        result |= unsigned(~Blocked(x - 1, word) >> bit & 1) << 0;
+      if (x + 1 < obstacles.Height())
+        result |= unsigned(~Blocked(x + 1, word) >> bit & 1) << 2;
+      // Left and right: the bits on either side, which may be in the next word.
+      uint64_t row = Blocked(x, word);
+      if (y > 0) {
+        uint64_t left = bit > 0 ? row : Blocked(x, word - 1);
+        result |= unsigned(~left >> ((bit + 63) % 64) & 1) << 1;
+      }
+      if (y + 1 < obstacles.Width()) {
+        uint64_t right = bit < 63 ? row : Blocked(x, word + 1);
+        result |= unsigned(~right >> ((bit + 1) % 64) & 1) << 3;
+      }
+      return result;
+    }
+
+    // Bytes of per-cell search state, not counting the open list.
+    size_t Bytes() const { return closed.Bytes() + parent_dirs.size(); }
+
+  private:
+    struct Entry {
+      Node node;
+      int dir;  // index into delta of the step that reached node
+    };
+
+    BitView obstacles;
+    BitGrid closed;
+    std::vector<uint8_t> parent_dirs;  // 2 bits per cell
+    std::vector<Entry> open;
+
+    static bool CompareEntries(const Entry &a, const Entry &b) { return Compare(a.node, b.node); }
+
+    bool OnBoard(int x, int y) const {
+      return x >= 0 && x < obstacles.Height() && y >= 0 && y < obstacles.Width();
+    }
+
+    uint64_t Blocked(int x, int word) const { return obstacles.Row(x)[word] | closed.Row(x)[word]; }
+
+    void Push(const Node &node, int dir) {
+      open.push_back(Entry{node, dir});
+      std::push_heap(open.begin(), open.end(), CompareEntries);
+    }
+
+    void SetParentDir(int x, int y, int dir) {
+      size_t i = size_t(x) * obstacles.Width() + y;
+      int shift = (i % 4) * 2;
+      parent_dirs[i / 4] = (parent_dirs[i / 4] & ~(3 << shift)) | (dir << shift);
+    }
+
+    int ParentDir(int x, int y) const {
+      size_t i = size_t(x) * obstacles.Width() + y;
+      return (parent_dirs[i / 4] >> ((i % 4) * 2)) & 3;
+    }
+
+    // Step back against the stored directions until init is reached.
+    std::vector<Point> BuildPath(int init[2], int goal[2]) const {
+      std::vector<Point> path{Point{goal[0], goal[1]}};
+      while (path.back() != Point{init[0], init[1]}) {
+        Point p = path.back();
+        int d = ParentDir(p.x, p.y);
+        path.push_back(Point{p.x - delta[d][0], p.y - delta[d][1]});
+      }
+      std::reverse(path.begin(), path.end());
+      return path;
+    }
+};
+
+#endif
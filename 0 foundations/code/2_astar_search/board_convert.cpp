@@ -0,0 +1,68 @@
+#include <iostream>
+#include <cstdlib>  // for atoi
+#include "board_file.h"
+#include "tiled_board.h"
+#include "weighted.h"
+using std::string;
+
+// Convert a CSV board file, as read by ReadBoardFile, to the binary format.
+// With --costs the values are read as traversal costs (0 = impassable,
+// 1..255 = cost) as in ReadCostBoardFile, and the cost layer is written too.
+// With --tiles N the output is a TiledBoard file of NxN tiles instead, written
+// while the input is read, so boards bigger than memory can be converted.
+// Usage: board_convert [--costs] files/1.board files/1.bboard
+//        board_convert --tiles 256 files/1.board files/1.tiles
+int main(int argc, char *argv[]) {
+  bool with_costs = argc == 4 && string(argv[1]) == "--costs";
+  bool with_tiles = argc == 5 && string(argv[1]) == "--tiles" && std::atoi(argv[2]) > 0;
+  if (argc != 3 && !with_costs && !with_tiles) {
+    std::cerr << "Usage: " << argv[0] << " [--costs] <input.board> <output.bboard>" << "\n";
+    std::cerr << "       " << argv[0] << " --tiles <size> <input.board> <output.tiles>" << "\n";
+    return 1;
+  }
+  string input = argv[argc - 2];
+  string output = argv[argc - 1];
+
+  if (with_tiles) {
+    if (!ConvertBoardFileToTiles(input, output, std::atoi(argv[2]))) {
+      std::cerr << "Could not convert " << input << " to " << output << "\n";
+      return 1;
+    }
+    TiledBoard check(output);
+    if (!check.Valid()) {
+      std::cerr << "Written board " << output << " is not valid" << "\n";
+      return 1;
+    }
+    std::cout << "Wrote " << check.Height() << "x" << check.Width() << " board in " << check.TileSize() << "x"
+              << check.TileSize() << " tiles to " << output << "\n";
+    return 0;
+  }
+
+  Grid board{};
+  CostGrid costs{};
+  if (with_costs) {
+    costs = ReadCostBoardFile(input);
+    board = Grid(costs.Height(), costs.Width());
+    for (int x = 0; x < costs.Height(); x++)
+      for (int y = 0; y < costs.Width(); y++)
+        if (costs(x, y) == 0)
+          board(x, y) = State::kObstacle;
+  } else {
+    board = MapBoardFile(input);
+  }
+  if (board.Empty()) {
+    std::cerr << "Could not read board from " << input << "\n";
+    return 1;
+  }
+  if (!WriteBinaryBoard(board, output, with_costs ? &costs.Costs() : nullptr)) {
+    std::cerr << "Could not write " << output << "\n";
+    return 1;
+  }
+  BinaryBoard check(output);
+  if (!check.Valid() || check.ToGrid() != board || (with_costs && CostGrid(check).Costs() != costs.Costs())) {
+    std::cerr << "Written board does not match " << input << "\n";
+    return 1;
+  }
+  std::cout << "Wrote " << board.Height() << "x" << board.Width() << " board to " << output << "\n";
+  return 0;
+}
@@ -0,0 +1,282 @@
+#ifndef BOARD_FILE_H
+#define BOARD_FILE_H
+
+#include <climits>  // for INT_MAX
+#include <cstdint>
+#include <cstring>  // for memchr, memcmp
+#include <fcntl.h>
+#include <fstream>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "astar.h"
+
+
+/**
+ * Read-only memory mapping of a whole file, unmapped when it goes out of scope.
+ * Data() is nullptr if the file could not be opened or is empty.
+ */
+class MappedFile {
+  public:
+    MappedFile(std::string path) : data(nullptr), size(0) {
+      int fd = open(path.c_str(), O_RDONLY);
+      if (fd < 0)
+        return;
+      struct stat info;
+      if (fstat(fd, &info) == 0 && info.st_size > 0) {
+        void *mapped = mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (mapped != MAP_FAILED) {
+          madvise(mapped, info.st_size, MADV_SEQUENTIAL);
+          data = static_cast<const char *>(mapped);
+          size = info.st_size;
+        }
+      }
+      close(fd);
+    }
+    ~MappedFile() {
+      if (data)
+        munmap(const_cast<char *>(data), size);
+    }
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+
+    const char *Data() const { return data; }
+    size_t Size() const { return size; }
+
+  private:
+    const char *data;
+    size_t size;
+};
+
+
+/**
+ * Tokenize one board line in [p, end) the same way ParseLine does: a cell is
+ * an integer followed by a comma, whitespace is skipped, and the row ends at
+ * the first thing that isn't. on_cell(column, value) is called per cell, with
+ * the value clamped to +-kMaxBoardValue. Returns the number of cells.
+ */
+const int kMaxBoardValue = 1 << 16;
+
+template <typename F>
+int ScanBoardLine(const char *p, const char *end, F on_cell) {
+  auto space = [](char c) { return c == ' ' || c == '\t' || c == '\r' || c == '\v' || c == '\f'; };
+  int column = 0;
+  while (true) {
+    while (p < end && space(*p))
+      p++;
+    int sign = 1;
+    if (p < end && (*p == '-' || *p == '+'))
+      sign = *p++ == '-' ? -1 : 1;
+    if (p == end || *p < '0' || *p > '9')
+      return column;
+    int value = 0;
+    for (; p < end && *p >= '0' && *p <= '9'; p++)
+      value = std::min(value * 10 + (*p - '0'), kMaxBoardValue);
+    while (p < end && space(*p))
+      p++;
+    if (p == end || *p != ',')
+      return column;
+    p++;
+    on_cell(column++, sign * value);
+  }
+}
+
+
+/**
+ * Walk a board file held in [begin, end). Counts the lines and the cells on
+ * the first line, which sets the width, then calls init(height, width) once
+ * and on_cell(x, y, value) for every cell within the width.
+ */
+template <typename Init, typename F>
+void ScanBoardFile(const char *begin, const char *end, Init init, F on_cell) {
+  int height = 0;
+  for (const char *p = begin; p < end; p++) {
+    p = static_cast<const char *>(memchr(p, '\n', end - p));
+    if (!p)
+      break;
+    height++;
+  }
+  if (end > begin && end[-1] != '\n')
+    height++;
+
+  const char *first_end = static_cast<const char *>(memchr(begin, '\n', end - begin));
+  int width = ScanBoardLine(begin, first_end ? first_end : end, [](int, int) {});
+  init(height, width);
+
+  const char *line = begin;
+  for (int x = 0; x < height; x++) {
+    const char *line_end = static_cast<const char *>(memchr(line, '\n', end - line));
+    if (!line_end)
+      line_end = end;
+    ScanBoardLine(line, line_end, [&](int y, int value) {
+      if (y < width)
+        on_cell(x, y, value);
+    });
+    line = line_end + 1;
+  }
+}
+
+
+/**
+ * Load a board file through mmap, for boards too big for ReadBoardFile.
+ * Gives the same board as ReadBoardFile: the first line sets the width, short
+ * rows are padded with obstacles and long rows cut. The grid is allocated
+ * once after counting lines, then every line is tokenized in place straight
+ * into it, with no per-line strings or streams. Returns an empty board if the
+ * file can't be read.
+ */
+inline Grid MapBoardFile(std::string path) {
+  MappedFile file(path);
+  if (!file.Data())
+    return Grid{};
+  Grid board{};
+  ScanBoardFile(file.Data(), file.Data() + file.Size(),
+                [&](int height, int width) { board = Grid(height, width, State::kObstacle); },
+                [&](int x, int y, int value) { board(x, y) = value != 0 ? State::kObstacle : State::kEmpty; });
+  return board;
+}
+
+
+// The binary and tiled formats are little-endian and read in place, so this
+// code only builds where the host byte order is the same.
+static_assert(__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__, "board files are read in place as little-endian");
+
+
+/**
+ * Binary board format, version 1. All values little-endian.
+ *   BinaryBoardHeader, padded to 64 bytes
+ *   obstacle layer: one bit per cell, 1 = obstacle, bit y % 64 of word y / 64
+ *                   in the row; every row starts on a new 64-bit word
+ *   cost layer:     optional, one byte per cell in row-major order
+ * Layers start on 64-byte boundaries so a mapped file can be used as is.
+ */
+struct BinaryBoardHeader {
+  char magic[4];           // "BRD1"
+  uint32_t version;
+  uint32_t height;
+  uint32_t width;
+  uint32_t encoding;       // kBinaryBoardHasCosts if the cost layer is present
+  uint32_t row_words;      // 64-bit words per obstacle row
+  uint64_t obstacle_offset;
+  uint64_t cost_offset;    // 0 without a cost layer
+};
+
+const char kBinaryBoardMagic[4]{'B', 'R', 'D', '1'};
+const uint32_t kBinaryBoardVersion = 1;
+const uint32_t kBinaryBoardHasCosts = 1;
+
+
+// Round n up to a multiple of 64.
+inline uint64_t AlignTo64(uint64_t n) { return (n + 63) / 64 * 64; }
+
+
+/**
+ * Write board in the binary format. costs, if given, holds one byte per cell
+ * in row-major order and is stored as the cost layer.
+ */
+inline bool WriteBinaryBoard(const Grid &board, std::string path, const std::vector<uint8_t> *costs = nullptr) {
+  if (costs && int(costs->size()) != board.Size())
+    return false;
+  BinaryBoardHeader header{};
+  std::memcpy(header.magic, kBinaryBoardMagic, 4);
+  header.version = kBinaryBoardVersion;
+  header.height = board.Height();
+  header.width = board.Width();
+  header.encoding = costs ? kBinaryBoardHasCosts : 0;
+  header.row_words = (board.Width() + 63) / 64;
+  header.obstacle_offset = AlignTo64(sizeof(header));
+  uint64_t obstacle_bytes = uint64_t(header.height) * header.row_words * 8;
+  header.cost_offset = costs ? AlignTo64(header.obstacle_offset + obstacle_bytes) : 0;
+
+  std::ofstream file(path, std::ios::binary);
+  if (!file)
+    return false;
+  std::vector<char> padding(64, 0);
+  file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+  file.write(padding.data(), header.obstacle_offset - sizeof(header));
+  std::vector<uint64_t> row(header.row_words);
+  for (int x = 0; x < board.Height(); x++) {
+    std::fill(row.begin(), row.end(), 0);
+    for (int y = 0; y < board.Width(); y++) {
+      if (board(x, y) == State::kObstacle)
+        row[y / 64] |= uint64_t(1) << (y % 64);
+    }
+    file.write(reinterpret_cast<const char *>(row.data()), row.size() * 8);
+  }
+  if (costs) {
+    file.write(padding.data(), header.cost_offset - header.obstacle_offset - obstacle_bytes);
+    file.write(reinterpret_cast<const char *>(costs->data()), costs->size());
+  }
+  return bool(file);
+}
+
+
+/**
+ * A binary board file mapped into memory and read in place: opening it only
+ * checks the header, cells are read straight from the mapping. BitView and
+ * CostView give BitSearchContext and WeightedSearchContext the layers as
+ * they are in the mapping, with nothing copied.
+ * A header whose layers don't fit in the file, or whose board has more than
+ * INT_MAX cells, which is what Grid and CostView can index, is rejected.
+ */
+class BinaryBoard {
+  public:
+    BinaryBoard(std::string path) : file(path), header(nullptr) {
+      if (file.Size() < sizeof(BinaryBoardHeader))
+        return;
+      auto h = reinterpret_cast<const BinaryBoardHeader *>(file.Data());
+      if (std::memcmp(h->magic, kBinaryBoardMagic, 4) != 0 || h->version != kBinaryBoardVersion)
+        return;
+      // height * width <= INT_MAX bounds every product below well inside 64 bits.
+      uint64_t cells = uint64_t(h->height) * h->width;
+      if (h->height > INT_MAX || h->width > INT_MAX || cells > INT_MAX ||
+          h->row_words != (uint64_t(h->width) + 63) / 64)
+        return;
+      uint64_t obstacle_bytes = uint64_t(h->height) * h->row_words * 8;
+      bool has_costs = h->encoding & kBinaryBoardHasCosts;
+      if (!Fits(h->obstacle_offset, obstacle_bytes) || (has_costs && !Fits(h->cost_offset, cells)))
+        return;
+      header = h;
+    }
+
+    bool Valid() const { return header != nullptr; }
+    int Height() const { return Valid() ? header->height : 0; }
+    int Width() const { return Valid() ? header->width : 0; }
+    bool HasCosts() const { return Valid() && (header->encoding & kBinaryBoardHasCosts); }
+
+    // Obstacle bits of row x, RowWords() words long.
+    const uint64_t *ObstacleRow(int x) const {
+      return reinterpret_cast<const uint64_t *>(file.Data() + header->obstacle_offset) + uint64_t(x) * header->row_words;
+    }
+    int RowWords() const { return header->row_words; }
+
+    bool Obstacle(int x, int y) const { return (ObstacleRow(x)[y / 64] >> (y % 64)) & 1; }
+
+    // Cost layer in row-major order, nullptr without one.
+    const uint8_t *CostLayer() const {
+      return HasCosts() ? reinterpret_cast<const uint8_t *>(file.Data() + header->cost_offset) : nullptr;
+    }
+
+    uint8_t Cost(int x, int y) const { return CostLayer()[uint64_t(x) * header->width + y]; }
+
+    // Copy into a Grid for the searches that take one.
+    Grid ToGrid() const {
+      Grid board(Height(), Width());
+      for (int x = 0; x < Height(); x++)
+        for (int y = 0; y < Width(); y++)
+          if (Obstacle(x, y))
+            board(x, y) = State::kObstacle;
+      return board;
+    }
+
+  private:
+    MappedFile file;
+    const BinaryBoardHeader *header;
+
+    // True if bytes bytes at a 64-byte aligned offset lie within the file.
+    bool Fits(uint64_t offset, uint64_t bytes) const {
+      return offset % 64 == 0 && offset <= file.Size() && bytes <= file.Size() - offset;
+    }
+};
+
+#endif
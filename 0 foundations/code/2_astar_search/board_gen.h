@@ -0,0 +1,121 @@
+#ifndef BOARD_GEN_H
+#define BOARD_GEN_H
+
+#include <cstdint>
+#include <random>
+#include <string>
+#include "astar.h"
+
+
+/**
+ * Deterministic board generators for tests and benchmarks. The same
+ * arguments always give the same board, on any platform: only std::mt19937
+ * output is used, never the standard distributions, whose results are
+ * implementation defined.
+ */
+
+// Each cell is an obstacle with probability percent / 100.
+inline Grid GenerateRandomBoard(int height, int width, int percent, unsigned seed) {
+  std::mt19937 rng(seed);
+  Grid board(height, width);
+  for (int x = 0; x < height; x++)
+    for (int y = 0; y < width; y++)
+      if (int(rng() % 100) < percent)
+        board(x, y) = State::kObstacle;
+  return board;
+}
+
+
+// No obstacles at all.
+inline Grid GenerateOpenField(int height, int width) {
+  return Grid(height, width);
+}
+
+
+/**
+ * Perfect maze with corridors one cell wide, carved by a depth-first walk
+ * from (0, 0). Cells with both coordinates even are the maze's rooms, so
+ * every one of them is reachable from every other by exactly one route.
+ */
+inline Grid GenerateMaze(int height, int width, unsigned seed) {
+  std::mt19937 rng(seed);
+  Grid board(height, width, State::kObstacle);
+  if (height <= 0 || width <= 0)
+    return board;
+  int rows = (height + 1) / 2;
+  int columns = (width + 1) / 2;
+  std::vector<bool> visited(size_t(rows) * columns, false);
+  std::vector<int> stack{0};
+  visited[0] = true;
+  board(0, 0) = State::kEmpty;
+  while (!stack.empty()) {
+    int r = stack.back() / columns;
+    int c = stack.back() % columns;
+    int options[4];
+    int count = 0;
+    for (int d = 0; d < 4; d++) {
+      int r2 = r + delta[d][0];
+      int c2 = c + delta[d][1];
+      if (r2 >= 0 && r2 < rows && c2 >= 0 && c2 < columns && !visited[size_t(r2) * columns + c2])
+        options[count++] = d;
+    }
+    if (count == 0) {
+      stack.pop_back();
+      continue;
+    }
+    int d = options[rng() % count];
+    int r2 = r + delta[d][0];
+    int c2 = c + delta[d][1];
+    visited[size_t(r2) * columns + c2] = true;
+    board(2 * r + delta[d][0], 2 * c + delta[d][1]) = State::kEmpty;
+    board(2 * r2, 2 * c2) = State::kEmpty;
+    stack.push_back(r2 * columns + c2);
+  }
+  return board;
+}
+
+
+/**
+ * Square rooms room_size cells across, separated by walls one cell thick.
+ * Every wall between two neighbouring rooms has one door at a random spot,
+ * so all rooms are connected.
+ */
+inline Grid GenerateRooms(int height, int width, int room_size, unsigned seed) {
+  std::mt19937 rng(seed);
+  Grid board(height, width);
+  int stride = room_size + 1;
+  for (int x = room_size; x < height; x += stride)
+    for (int y = 0; y < width; y++)
+      board(x, y) = State::kObstacle;
+  for (int y = room_size; y < width; y += stride)
+    for (int x = 0; x < height; x++)
+      board(x, y) = State::kObstacle;
+  // Doors: one in each wall segment, skipping the corners where walls cross.
+  for (int x = room_size; x < height; x += stride)
+    for (int y0 = 0; y0 < width; y0 += stride)
+      board(x, y0 + int(rng() % std::min(room_size, width - y0))) = State::kEmpty;
+  for (int y = room_size; y < width; y += stride)
+    for (int x0 = 0; x0 < height; x0 += stride)
+      board(x0 + int(rng() % std::min(room_size, height - x0)), y) = State::kEmpty;
+  return board;
+}
+
+
+/**
+ * Board by name, for command lines: "open", "maze", "rooms" or "randomN"
+ * with N the obstacle percentage. Returns an empty board for other names.
+ */
+inline Grid GenerateBoard(const std::string &kind, int height, int width, unsigned seed) {
+  if (kind == "open")
+    return GenerateOpenField(height, width);
+  if (kind == "maze")
+    return GenerateMaze(height, width, seed);
+  if (kind == "rooms")
+    return GenerateRooms(height, width, 16, seed);
+  if (kind.compare(0, 6, "random") == 0 && kind.size() > 6 && kind.size() <= 9 &&
+      kind.find_first_not_of("0123456789", 6) == std::string::npos)
+    return GenerateRandomBoard(height, width, std::stoi(kind.substr(6)), seed);
+  return Grid{};
+}
+
+#endif
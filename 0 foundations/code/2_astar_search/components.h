@@ -0,0 +1,331 @@
+#ifndef COMPONENTS_H
+#define COMPONENTS_H
+
+#include <thread>
+#include "astar.h"
+
+
+/**
+ * Connected components of the open cells of a board, so a query between
+ * two cells that can't reach each other is answered without searching.
+ * Every open cell is labelled with the id of its component, obstacles with
+ * -1; two cells are connected iff their labels match. Ids are in
+ * [0, W*H) and never shared by two components; ids of components that
+ * disappear are reused.
+ *
+ * The labels are built by union-find over horizontal bands of rows, one band
+ * per thread, and then the bands are joined along their edges. After an
+ * edit to the board, Update(x, y) repairs the labels around that cell:
+ * opening a cell merges the components around it by relabelling all but
+ * the largest. Blocking one may split its component: a search from each
+ * open neighbour is run in lockstep until all but one have either met
+ * another or run out, and only the parts that ran out are relabelled. The
+ * cost is about the size of the parts split off times the number of
+ * searches, or when nothing splits, what the searches cover before they
+ * meet, which is a few cells in open space but can be most of a component
+ * that is a thin loop. The board must outlive the map.
+ */
+class ComponentMap {
+  public:
+    ComponentMap(const Grid &board, int workers = 0)
+        : board(board), label(board.Size(), -1), sizes(board.Size(), 0), part(board.Size(), -1), last_update_cells(0) {
+      Build(workers);
+    }
+
+    // Component id of (x, y), or -1 for obstacles and cells off the board.
+    int Component(int x, int y) const {
+      if (!OnBoard(x, y))
+        return -1;
+      return label[board.Index(x, y)];
+    }
+
+    // Number of cells in component id.
+    int ComponentSize(int id) const { return id < 0 ? 0 : sizes[id]; }
+
+    // True if a path from init to goal exists. O(1).
+    bool Connected(Point init, Point goal) const {
+      int a = Component(init.x, init.y);
+      return a != -1 && a == Component(goal.x, goal.y);
+    }
+
+    // context.Search, but an unreachable goal returns at once.
+    std::vector<Point> Search(SearchContext &context, Point init, Point goal) const {
+      if (!Connected(init, goal))
+        return std::vector<Point>{};
+      return context.Search(init, goal);
+    }
+
+    // Cells the last call to Update visited while relabelling.
+    int LastUpdateCells() const { return last_update_cells; }
+
+    /**
+     * Bring the labels up to date after board(x, y) changed between open and
+     * obstacle. Calling it for a cell that didn't change, or one off the
+     * board, does nothing.
+     */
+    void Update(int x, int y) {
+      last_update_cells = 0;
+      if (!OnBoard(x, y))
+        return;
+      int i = board.Index(x, y);
+      bool open = Open(x, y);
+      if (open == (label[i] != -1))
+        return;
+
+      std::vector<int> around{};
+      for (int d = 0; d < 4; d++) {
+        int x2 = x + delta[d][0];
+        int y2 = y + delta[d][1];
+        if (Open(x2, y2))
+          around.push_back(board.Index(x2, y2));
+      }
+
+      if (open) {
+        // Join the cell and its neighbours' components into the largest one.
+        int largest = -1;
+        for (int j : around)
+          if (largest == -1 || sizes[label[j]] > sizes[largest])
+            largest = label[j];
+        if (largest == -1) {
+          label[i] = NewId();
+          sizes[label[i]] = 1;
+          return;
+        }
+        label[i] = largest;
+        sizes[largest]++;
+        for (int j : around)
+          if (label[j] != largest) {
+            int from = label[j];
+            int moved = Flood(j, from, largest);
+            sizes[largest] += moved;
+            last_update_cells += moved;
+            sizes[from] = 0;
+            free_ids.push_back(from);
+          }
+        return;
+      }
+
+      int old_id = label[i];
+      label[i] = -1;
+      sizes[old_id]--;
+      if (sizes[old_id] == 0)
+        free_ids.push_back(old_id);
+      if (around.size() > 1)
+        Split(old_id, around);
+    }
+
+  private:
+    const Grid &board;
+    std::vector<int> label;
+    std::vector<int> sizes;  // indexed by component id
+    std::vector<int> free_ids;  // ids no component has
+    std::vector<int> queue;
+    std::vector<signed char> part;  // which of Split's searches reached a cell, -1 for none
+    int last_update_cells;
+
+    bool OnBoard(int x, int y) const { return x >= 0 && x < board.Height() && y >= 0 && y < board.Width(); }
+
+    bool Open(int x, int y) const { return OnBoard(x, y) && board(x, y) != State::kObstacle; }
+
+    int NewId() {
+      int id = free_ids.back();
+      free_ids.pop_back();
+      return id;
+    }
+
+    /**
+     * Component id's cells next to a cell just blocked were the seeds: find
+     * which parts id fell apart into. One search per seed takes a cell in
+     * turn; searches that touch are joined into one group. Once at most one
+     * group can still grow, every group that ran out is a part of its own
+     * and gets a new id, and the rest keep id.
+     */
+    void Split(int id, const std::vector<int> &seeds) {
+      int count = seeds.size();
+      std::vector<int> cells[4];  // cells each search reached, in order
+      size_t head[4]{};
+      int group[4];  // union-find over the searches
+      for (int s = 0; s < count; s++) {
+        group[s] = s;
+        cells[s].assign(1, seeds[s]);
+        part[seeds[s]] = s;
+      }
+      auto root = [&](int s) {
+        while (group[s] != s)
+          s = group[s];
+        return s;
+      };
+      // A group can grow while any of its searches has cells left to expand.
+      auto growing = [&](int g) {
+        for (int s = 0; s < count; s++)
+          if (root(s) == g && head[s] < cells[s].size())
+            return true;
+        return false;
+      };
+
+      int w = board.Width();
+      while (true) {
+        int live = 0;
+        for (int g = 0; g < count; g++)
+          live += root(g) == g && growing(g);
+        if (live <= 1)
+          break;
+        for (int g = 0; g < count; g++) {
+          if (root(g) != g)
+            continue;
+          int s = 0;
+          while (s < count && (root(s) != g || head[s] == cells[s].size()))
+            s++;
+          if (s == count)
+            continue;
+          int c = cells[s][head[s]++];
+          for (int d = 0; d < 4; d++) {
+            int x2 = c / w + delta[d][0];
+            int y2 = c % w + delta[d][1];
+            if (!OnBoard(x2, y2) || label[board.Index(x2, y2)] != id)
+              continue;
+            int j = board.Index(x2, y2);
+            if (part[j] == -1) {
+              part[j] = s;
+              cells[s].push_back(j);
+            } else if (root(part[j]) != root(s)) {
+              group[root(part[j])] = root(s);
+            }
+          }
+        }
+      }
+
+      // Groups that ran out are cut off. One that can still grow keeps id,
+      // or if none can, the one with the most cells does.
+      int keep = -1;
+      size_t most = 0;
+      for (int g = 0; g < count; g++) {
+        if (root(g) != g)
+          continue;
+        size_t size = 0;
+        for (int s = 0; s < count; s++)
+          size += root(s) == g ? cells[s].size() : 0;
+        if (growing(g))
+          size = board.Size();
+        if (keep == -1 || size > most) {
+          keep = g;
+          most = size;
+        }
+      }
+      for (int g = 0; g < count; g++) {
+        if (root(g) != g || g == keep)
+          continue;
+        int to = NewId();
+        for (int s = 0; s < count; s++) {
+          if (root(s) != g)
+            continue;
+          for (int c : cells[s])
+            label[c] = to;
+          sizes[to] += cells[s].size();
+          sizes[id] -= cells[s].size();
+        }
+      }
+      for (int s = 0; s < count; s++) {
+        for (int c : cells[s])
+          part[c] = -1;
+        last_update_cells += cells[s].size();
+      }
+    }
+
+    /**
+     * Relabel the cells labelled from that are reachable from start through
+     * cells labelled from, as to. Returns how many there were.
+     */
+    int Flood(int start, int from, int to) {
+      int w = board.Width();
+      label[start] = to;
+      queue.assign(1, start);
+      for (size_t head = 0; head < queue.size(); head++) {
+        int x = queue[head] / w;
+        int y = queue[head] % w;
+        for (int d = 0; d < 4; d++) {
+          int x2 = x + delta[d][0];
+          int y2 = y + delta[d][1];
+          if (x2 < 0 || x2 >= board.Height() || y2 < 0 || y2 >= w || label[board.Index(x2, y2)] != from)
+            continue;
+          label[board.Index(x2, y2)] = to;
+          queue.push_back(board.Index(x2, y2));
+        }
+      }
+      return queue.size();
+    }
+
+    // Root of i's tree, halving the path on the way up.
+    static int Find(std::vector<int> &parent, int i) {
+      while (parent[i] != i) {
+        parent[i] = parent[parent[i]];
+        i = parent[i];
+      }
+      return i;
+    }
+
+    // The lower root becomes the parent, so roots are stable within a band.
+    static void Union(std::vector<int> &parent, int a, int b) {
+      a = Find(parent, a);
+      b = Find(parent, b);
+      if (a < b)
+        parent[b] = a;
+      else if (b < a)
+        parent[a] = b;
+    }
+
+    void Build(int workers) {
+      int h = board.Height();
+      int w = board.Width();
+      if (workers <= 0)
+        workers = std::max(1u, std::thread::hardware_concurrency());
+      workers = std::max(1, std::min(workers, h));
+
+      // label doubles as the union-find parent array while building.
+      std::vector<int> &parent = label;
+      auto band_start = [&](int band) { return int(int64_t(h) * band / workers); };
+      auto label_band = [&](int band) {
+        for (int x = band_start(band); x < band_start(band + 1); x++) {
+          for (int y = 0; y < w; y++) {
+            if (!Open(x, y))
+              continue;
+            int i = board.Index(x, y);
+            parent[i] = i;
+            if (Open(x, y - 1))
+              Union(parent, i, i - 1);
+            if (x > band_start(band) && Open(x - 1, y))
+              Union(parent, i, i - w);
+          }
+        }
+      };
+      std::vector<std::thread> threads;
+      for (int band = 1; band < workers; band++)
+        threads.emplace_back(label_band, band);
+      label_band(0);
+      for (auto &t : threads)
+        t.join();
+
+      // Join the bands along the rows where they meet.
+      for (int band = 1; band < workers; band++) {
+        int x = band_start(band);
+        for (int y = 0; y < w; y++)
+          if (x > 0 && Open(x, y) && Open(x - 1, y))
+            Union(parent, board.Index(x, y), board.Index(x - 1, y));
+      }
+
+      // Point every cell straight at its root, rows in increasing order so a
+      // cell's parent, which has a lower index, is always done before it.
+      for (int i = 0; i < board.Size(); i++) {
+        if (parent[i] == -1)
+          continue;
+        parent[i] = parent[parent[i]];
+        sizes[parent[i]]++;
+      }
+      // Roots are the ids in use, the rest are free.
+      for (int i = board.Size() - 1; i >= 0; i--)
+        if (sizes[i] == 0)
+          free_ids.push_back(i);
+    }
+};
+
+#endif
@@ -0,0 +1,265 @@
+#ifndef COOPERATIVE_H
+#define COOPERATIVE_H
+
+#include <cstdint>
+#include <unordered_map>
+#include <unordered_set>
+#include "astar.h"
+
+
+/**
+ * Cells and moves claimed by agents, by time step.
+ * An agent occupies a cell at every step of its path, and after its last step
+ * it stays on its goal for good, so that cell is claimed from then on. Moves
+ * are claimed too, so two agents never swap cells in one step. An agent that
+ * hasn't moved yet, or never will, is parked on its start from step 0.
+ */
+class ReservationTable {
+  public:
+    // True if cell is taken at step t.
+    bool Taken(int cell, int t) const {
+      if (cells.count(Key(cell, t)))
+        return true;
+      auto parked = parked_at.find(cell);
+      return parked != parked_at.end() && t >= parked->second;
+    }
+
+    // True if an agent rests on cell from some step on.
+    bool Parked(int cell) const { return parked_at.count(cell); }
+
+    // True if some agent moves from cell along delta[d] between steps t and t + 1.
+    bool Moving(int cell, int d, int t) const { return moves.count(Key(cell * 4 + d, t)); }
+
+    // Last step cell is claimed before anyone parks on it, -1 if never.
+    int LastUse(int cell) const {
+      auto found = last_use.find(cell);
+      return found == last_use.end() ? -1 : found->second;
+    }
+
+    // Claim path, one cell per step from step 0, then park on its last cell.
+    void Reserve(const std::vector<Point> &path, int width) {
+      for (size_t t = 0; t < path.size(); t++) {
+        int cell = path[t].x * width + path[t].y;
+        cells.insert(Key(cell, t));
+        int &last = last_use.emplace(cell, -1).first->second;
+        last = std::max(last, int(t));
+        if (t + 1 < path.size())
+          for (int d = 0; d < 4; d++)
+            if (path[t + 1].x == path[t].x + delta[d][0] && path[t + 1].y == path[t].y + delta[d][1])
+              moves.insert(Key(cell * 4 + d, t));
+      }
+      if (!path.empty())
+        Park(path.back().x * width + path.back().y, path.size() - 1);
+    }
+
+    // Claim cell from step t on, for an agent that stays there.
+    void Park(int cell, int t) { parked_at[cell] = t; }
+
+    // Give back a parked cell, for an agent about to be planned from it.
+    void Unpark(int cell) { parked_at.erase(cell); }
+
+    void Clear() {
+      cells.clear();
+      moves.clear();
+      parked_at.clear();
+      last_use.clear();
+    }
+
+    // Claimed (cell, step) pairs, not counting parked agents.
+    size_t Size() const { return cells.size(); }
+
+  private:
+    std::unordered_set<uint64_t> cells;   // (cell, t)
+    std::unordered_set<uint64_t> moves;   // (cell * 4 + d, t)
+    std::unordered_map<int, int> parked_at;  // cell -> first step an agent rests there
+    std::unordered_map<int, int> last_use;   // cell -> last step it is claimed
+
+    static uint64_t Key(int a, int t) { return uint64_t(uint32_t(a)) << 32 | uint32_t(t); }
+};
+
+
+/**
+ * Cooperative A*: agents are planned one after the other, each with A* in
+ * (x, y, t) that steers around the cells and moves the agents before it
+ * claimed in a shared ReservationTable. Every step an agent moves to a
+ * neighbour or waits where it is, at a cost of 1 either way. The heuristic
+ * is the true distance to the goal on the empty board, found by a
+ * breadth-first search from the goal, so an agent only detours or waits
+ * where others are in the way. Paths are given one cell per step, waits
+ * repeating the cell, and an agent rests on its goal once it gets there.
+ *
+ * An agent may take at most slack steps more than it would alone on the
+ * board, and its search gives up after max_expanded states, since proving
+ * that an agent is boxed in means trying every cell at every step. One that
+ * can't get to its goal gets an empty path and stays parked on its start,
+ * where the agents after it steer around it, unless an agent before it
+ * already goes through that cell (see Plan). PlanAll parks every agent on its
+ * start before planning any, so earlier agents never run through a later
+ * one waiting to move. The order still matters: an agent fails while its
+ * goal is another's start or its way out is held by agents not yet planned,
+ * and PlanAll tries it again once those have moved. The board must outlive
+ * the planner.
+ */
+class CooperativePlanner {
+  public:
+    // slack and max_expanded of 0 pick 2 * (height + width) and 4 * cells.
+    CooperativePlanner(const Grid &board, int slack = 0, long long max_expanded = 0)
+        : board(board), slack(slack > 0 ? slack : 2 * (board.Height() + board.Width())),
+          max_expanded(max_expanded > 0 ? max_expanded : 4LL * board.Size()),
+          distance(board.Size(), -1), expanded(0) {}
+
+    /**
+     * Plan one agent from init to goal around the agents planned or parked so
+     * far, and claim its path. Returns the cell at each step from 0 until it
+     * reaches goal, or an empty vector if it can't, in which case the agent
+     * is parked on init. If an agent planned earlier passes through or rests
+     * on init, the agent can't be parked there either: it is left off the
+     * table and *conflict, if given, is set to true.
+     */
+    std::vector<Point> Plan(Point init, Point goal, bool *conflict = nullptr) {
+      if (conflict)
+        *conflict = false;
+      std::vector<Point> path = Run(init, goal);
+      if (!path.empty()) {
+        reservations.Reserve(path, board.Width());
+      } else if (CheckValidCell(init.x, init.y, board)) {
+        int start = board.Index(init.x, init.y);
+        if (reservations.LastUse(start) == -1 && !reservations.Parked(start))
+          reservations.Park(start, 0);
+        else if (conflict)
+          *conflict = true;
+      }
+      return path;
+    }
+
+    /**
+     * Plan the agents in order, then go over the ones that failed again for
+     * as long as that plans any more of them: an agent that moved off its
+     * start may have made room. Results line up with queries.
+     */
+    std::vector<std::vector<Point>> PlanAll(const std::vector<Query> &queries) {
+      for (auto &query : queries)
+        if (CheckValidCell(query.init.x, query.init.y, board))
+          reservations.Park(board.Index(query.init.x, query.init.y), 0);
+      std::vector<std::vector<Point>> paths(queries.size());
+      long long total = 0;
+      for (bool progress = true; progress;) {
+        progress = false;
+        for (size_t a = 0; a < queries.size(); a++) {
+          Point init = queries[a].init;
+          if (!paths[a].empty() || !CheckValidCell(init.x, init.y, board))
+            continue;
+          reservations.Unpark(board.Index(init.x, init.y));
+          paths[a] = Plan(init, queries[a].goal);
+          total += expanded;
+          progress = progress || !paths[a].empty();
+        }
+      }
+      expanded = total;
+      return paths;
+    }
+
+    // Forget every agent planned so far.
+    void Clear() { reservations.Clear(); }
+
+    const ReservationTable &Reservations() const { return reservations; }
+
+    // (x, y, t) states expanded by the last Plan, or all of the last PlanAll.
+    long long Expanded() const { return expanded; }
+
+  private:
+    const Grid &board;
+    int slack;
+    long long max_expanded;
+    ReservationTable reservations;
+    std::vector<int> distance;  // steps to the current goal, -1 if it can't be reached
+    Point distance_goal{-1, -1};
+    std::vector<Node> open;
+    std::unordered_map<uint64_t, uint64_t> parent;  // state -> state it was reached from
+    long long expanded;
+
+    static uint64_t StateKey(int cell, int t) { return uint64_t(uint32_t(cell)) << 32 | uint32_t(t); }
+
+    // Breadth-first distances to goal, kept while the goal stays the same.
+    void Distances(Point goal) {
+      if (goal == distance_goal)
+        return;
+      distance_goal = goal;
+      std::fill(distance.begin(), distance.end(), -1);
+      int w = board.Width();
+      std::vector<int> queue{board.Index(goal.x, goal.y)};
+      distance[queue[0]] = 0;
+      for (size_t head = 0; head < queue.size(); head++) {
+        int x = queue[head] / w;
+        int y = queue[head] % w;
+        for (int d = 0; d < 4; d++) {
+          int x2 = x + delta[d][0];
+          int y2 = y + delta[d][1];
+          if (CheckValidCell(x2, y2, board) && distance[board.Index(x2, y2)] == -1) {
+            distance[board.Index(x2, y2)] = distance[queue[head]] + 1;
+            queue.push_back(board.Index(x2, y2));
+          }
+        }
+      }
+    }
+
+    std::vector<Point> Run(Point init, Point goal) {
+      expanded = 0;
+      std::vector<Point> path{};
+      if (!CheckValidCell(init.x, init.y, board) || !CheckValidCell(goal.x, goal.y, board))
+        return path;
+      int start = board.Index(init.x, init.y);
+      int target = board.Index(goal.x, goal.y);
+      if (reservations.Taken(start, 0) || reservations.Parked(target))
+        return path;
+      Distances(goal);
+      if (distance[start] == -1)
+        return path;
+      // The agent may only stop on its goal once nobody else passes through.
+      int earliest = reservations.LastUse(target) + 1;
+      int horizon = std::max(distance[start], earliest) + slack;
+
+      open.clear();
+      parent.clear();
+      parent.emplace(StateKey(start, 0), StateKey(start, 0));
+      open.push_back(Node{init.x, init.y, 0, std::max(distance[start], earliest)});
+      while (open.size() > 0 && expanded < max_expanded) {
+        Node current = PopFromOpen(open);
+        int cell = board.Index(current.x, current.y);
+        int t = current.g;
+        expanded++;
+        if (cell == target && t >= earliest) {
+          for (uint64_t s = StateKey(cell, t);; s = parent[s]) {
+            int c = int(s >> 32);
+            path.push_back(Point{c / board.Width(), c % board.Width()});
+            if (parent[s] == s)
+              break;
+          }
+          std::reverse(path.begin(), path.end());
+          return path;
+        }
+        if (t >= horizon)
+          continue;
+        // Moves along delta, then waiting in place.
+        for (int d = 0; d <= 4; d++) {
+          int x2 = current.x + (d < 4 ? delta[d][0] : 0);
+          int y2 = current.y + (d < 4 ? delta[d][1] : 0);
+          if (!CheckValidCell(x2, y2, board))
+            continue;
+          int next = board.Index(x2, y2);
+          // Still admissible: the agent can't stop before earliest either.
+          int h = std::max(distance[next], earliest - (t + 1));
+          if (t + 1 + h > horizon || reservations.Taken(next, t + 1) ||
+              (d < 4 && reservations.Moving(next, (d + 2) % 4, t)))
+            continue;
+          if (!parent.emplace(StateKey(next, t + 1), StateKey(cell, t)).second)
+            continue;
+          open.push_back(Node{x2, y2, t + 1, h});
+          std::push_heap(open.begin(), open.end(), Compare);
+        }
+      }
+      return path;
+    }
+};
+
+#endif
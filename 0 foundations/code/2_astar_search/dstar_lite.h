@@ -0,0 +1,218 @@
+#ifndef DSTAR_LITE_H
+#define DSTAR_LITE_H
+
+#include <functional>  // for greater
+#include <queue>
+#include <utility>  // for pair
+#include "astar.h"
+
+
+// A cell that switched between kEmpty and kObstacle.
+struct CellChange {
+  Point cell;
+  State state;
+};
+
+
+/**
+ * Incremental planner (D* Lite) for a board whose cells change over time.
+ * It searches backward from the goal and keeps its g/rhs values between calls.
+ * ChangeCells and MoveStart only queue the cells whose values might now be
+ * wrong. The next Plan repairs just those, so after a small edit it does a
+ * fraction of the work of a new search. The planner keeps its own copy of the
+ * board, which ChangeCells edits.
+ */
+class DStarLite {
+  public:
+    DStarLite(const Grid &board, Point start, Point goal)
+        : board(board), start(start), last_start(start), goal(goal), km(0), expansions(0),
+          g(board.Size(), kInfinity), rhs(board.Size(), kInfinity),
+          in_queue(board.Size(), false), queued_key(board.Size()) {
+      if (OnBoard(goal.x, goal.y)) {
+        rhs[Index(goal)] = 0;
+        Insert(Index(goal));
+      }
+    }
+
+    const Grid &Board() const { return board; }
+
+    // Cells expanded by the last call to Plan.
+    int Expansions() const { return expansions; }
+
+    /**
+     * Bring the plan up to date and return the path from the current start
+     * to the goal, or an empty vector if the goal can't be reached.
+     */
+    std::vector<Point> Plan() {
+      SyncStart();
+      ComputeShortestPath();
+      std::vector<Point> path{};
+      if (!OnBoard(start.x, start.y) || g[Index(start)] >= kInfinity)
+        return path;
+      // Follow the cheapest neighbour down the g values to the goal.
+      path.push_back(start);
+      while (path.back() != goal) {
+        Point p = path.back();
+        int best_cost = kInfinity;
+        Point best = p;
+        for (int d = 0; d < 4; d++) {
+          Point n{p.x + delta[d][0], p.y + delta[d][1]};
+          if (!Passable(n.x, n.y))
+            continue;
+          int cost = 1 + g[Index(n)];
+          if (cost < best_cost) {
+            best_cost = cost;
+            best = n;
+          }
+        }
+        if (best_cost >= kInfinity)
+          return std::vector<Point>{};
+        path.push_back(best);
+      }
+      return path;
+    }
+
+    // The agent moved: later plans start from here.
+    void MoveStart(Point new_start) {
+      start = new_start;
+    }
+
+    /**
+     * Apply cell edits to the board. Only the edited cells and their
+     * neighbours are queued for repair.
+     */
+    void ChangeCells(const std::vector<CellChange> &changes) {
+      SyncStart();
+      for (auto &change : changes) {
+        Point c = change.cell;
+        if (!OnBoard(c.x, c.y) || board(c.x, c.y) == change.state)
+          continue;
+        board(c.x, c.y) = change.state;
+        UpdateVertex(Index(c));
+        for (int d = 0; d < 4; d++) {
+          int x2 = c.x + delta[d][0];
+          int y2 = c.y + delta[d][1];
+          if (OnBoard(x2, y2))
+            UpdateVertex(board.Index(x2, y2));
+        }
+      }
+    }
+
+  private:
+    typedef std::pair<int, int> Key;
+    typedef std::pair<Key, int> QueueEntry;
+
+    static constexpr int kInfinity = 1 << 29;
+
+    Grid board;
+    Point start;
+    Point last_start;
+    Point goal;
+    int km;
+    int expansions;
+    std::vector<int> g;
+    std::vector<int> rhs;
+    // Queue entries are never removed in place: an entry is live only if its
+    // cell is still queued with the same key.
+    std::priority_queue<QueueEntry, std::vector<QueueEntry>, std::greater<QueueEntry>> queue;
+    std::vector<bool> in_queue;
+    std::vector<Key> queued_key;
+
+    int Index(Point p) const { return board.Index(p.x, p.y); }
+
+    bool OnBoard(int x, int y) const {
+      return x >= 0 && x < board.Height() && y >= 0 && y < board.Width();
+    }
+
+    bool Passable(int x, int y) const {
+      return OnBoard(x, y) && board(x, y) != State::kObstacle;
+    }
+
+    Key CalculateKey(int i) const {
+      int w = board.Width();
+      int m = std::min(g[i], rhs[i]);
+      return Key{m + Heuristic(start.x, start.y, i / w, i % w) + km, m};
+    }
+
+    void Insert(int i) {
+      in_queue[i] = true;
+      queued_key[i] = CalculateKey(i);
+      queue.push(QueueEntry{queued_key[i], i});
+    }
+
+    // Drop dead entries so queue.top() is live.
+    void SkipStale() {
+      while (!queue.empty() && (!in_queue[queue.top().second] || queued_key[queue.top().second] != queue.top().first))
+        queue.pop();
+    }
+
+    Key TopKey() {
+      SkipStale();
+      return queue.empty() ? Key{kInfinity, kInfinity} : queue.top().first;
+    }
+
+    // Keys already queued were computed from last_start, km makes up for the move.
+    void SyncStart() {
+      km += Heuristic(last_start.x, last_start.y, start.x, start.y);
+      last_start = start;
+    }
+
+    void UpdateVertex(int i) {
+      int w = board.Width();
+      int x = i / w;
+      int y = i % w;
+      if (i != Index(goal)) {
+        rhs[i] = kInfinity;
+        if (Passable(x, y)) {
+          for (int d = 0; d < 4; d++) {
+            int x2 = x + delta[d][0];
+            int y2 = y + delta[d][1];
+            if (Passable(x2, y2))
+              rhs[i] = std::min(rhs[i], std::min(kInfinity, 1 + g[board.Index(x2, y2)]));
+          }
+        }
+      }
+      in_queue[i] = false;
+      if (g[i] != rhs[i])
+        Insert(i);
+    }
+
+    void UpdateNeighbors(int i) {
+      int w = board.Width();
+      for (int d = 0; d < 4; d++) {
+        int x2 = i / w + delta[d][0];
+        int y2 = i % w + delta[d][1];
+        if (OnBoard(x2, y2))
+          UpdateVertex(board.Index(x2, y2));
+      }
+    }
+
+    void ComputeShortestPath() {
+      expansions = 0;
+      if (!OnBoard(start.x, start.y))
+        return;
+      int s = Index(start);
+      while (TopKey() < CalculateKey(s) || rhs[s] != g[s]) {
+        if (queue.empty())
+          break;
+        Key old_key = queue.top().first;
+        int u = queue.top().second;
+        queue.pop();
+        in_queue[u] = false;
+        expansions++;
+        Key new_key = CalculateKey(u);
+        if (old_key < new_key) {
+          Insert(u);
+        } else if (g[u] > rhs[u]) {
+          g[u] = rhs[u];
+          UpdateNeighbors(u);
+        } else {
+          g[u] = kInfinity;
+          UpdateVertex(u);
+          UpdateNeighbors(u);
+        }
+      }
+    }
+};
+
+#endif
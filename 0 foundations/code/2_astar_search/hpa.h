@@ -0,0 +1,405 @@
+#ifndef HPA_H
+#define HPA_H
+
+#include <cstdint>
+#include <fstream>
+#include <functional>  // for greater
+#include <queue>
+#include <unordered_map>
+#include <utility>  // for pair
+#include <vector>
+#include "astar.h"
+
+
+/**
+ * Hierarchical pathfinding (HPA*) over a board.
+ * The board is cut into square clusters. Wherever two neighbouring clusters
+ * share a run of open border cells, an entrance is placed: the cells on both
+ * sides become abstract nodes joined by a step of cost 1. Inside each cluster
+ * every pair of nodes that can reach each other is joined with its in-cluster
+ * distance. A query searches this small abstract graph and then fills in the
+ * cells cluster by cluster, so its cost depends on the number of entrances
+ * on the route rather than on the size of the board.
+ * Paths are valid but can be slightly longer than the shortest path, as they
+ * must pass through entrances. Search adds the endpoints to the graph for the
+ * duration of a query, so one HierarchicalMap must not be searched from
+ * several threads at once. The board must outlive the map.
+ * A cluster_size below 1 is taken as 1, and one above the board's longer
+ * side as that side, so one cluster covers the board.
+ */
+class HierarchicalMap {
+  public:
+    HierarchicalMap(const Grid &board, int cluster_size = 16)
+        : board(board), cluster_size(std::max(1, std::min(cluster_size, std::max(board.Height(), board.Width())))),
+          cluster_rows((board.Height() + this->cluster_size - 1) / this->cluster_size),
+          cluster_cols((board.Width() + this->cluster_size - 1) / this->cluster_size),
+          local_dist(LocalSize()), local_parent(LocalSize()) {
+      Clear();
+    }
+
+    int NodeCount() const { return node_cells.size(); }
+
+    /**
+     * Precompute entrances and in-cluster distances for the whole board.
+     */
+    void Build() {
+      Clear();
+      for (int cx = 0; cx < cluster_rows; cx++) {
+        for (int cy = 0; cy < cluster_cols; cy++) {
+          int x1 = std::min((cx + 1) * cluster_size, board.Height());
+          int y1 = std::min((cy + 1) * cluster_size, board.Width());
+          // Border with the cluster below, then with the cluster to the right.
+          if (x1 < board.Height())
+            AddEntrances(x1 - 1, cy * cluster_size, 0, 1, y1 - cy * cluster_size, 1, 0);
+          if (y1 < board.Width())
+            AddEntrances(cx * cluster_size, y1 - 1, 1, 0, x1 - cx * cluster_size, 0, 1);
+        }
+      }
+      for (auto &nodes : cluster_nodes) {
+        for (int a : nodes)
+          ConnectInCluster(a, nodes, false);
+      }
+    }
+
+    /**
+     * Write the abstraction to disk so it can be loaded instead of rebuilt.
+     * The file records the board size and a hash of its cells.
+     */
+    bool Save(std::string path) const {
+      std::ofstream file(path, std::ios::binary);
+      if (!file)
+        return false;
+      Write(file, kMagic);
+      Write(file, kVersion);
+      Write(file, board.Height());
+      Write(file, board.Width());
+      Write(file, cluster_size);
+      Write(file, BoardHash());
+      Write(file, NodeCount());
+      for (int n = 0; n < NodeCount(); n++) {
+        Write(file, node_cells[n]);
+        Write(file, int(edges[n].size()));
+        for (auto &e : edges[n]) {
+          Write(file, e.to);
+          Write(file, e.cost);
+        }
+      }
+      return bool(file);
+    }
+
+    /**
+     * Read an abstraction written by Save. Returns false, leaving the map
+     * empty, if the file is missing, damaged or was built for another board.
+     */
+    bool Load(std::string path) {
+      Clear();
+      std::ifstream file(path, std::ios::binary);
+      uint32_t magic = 0, version = 0;
+      uint64_t hash = 0;
+      int height = 0, width = 0, size = 0, count = 0;
+      if (!Read(file, magic) || magic != kMagic || !Read(file, version) || version != kVersion)
+        return false;
+      if (!Read(file, height) || !Read(file, width) || !Read(file, size) || !Read(file, hash) ||
+          height != board.Height() || width != board.Width() || size != cluster_size ||
+          hash != BoardHash() || !Read(file, count) || count < 0)
+        return false;
+      for (int n = 0; n < count; n++) {
+        int cell = 0, degree = 0;
+        if (!Read(file, cell) || !Read(file, degree) || cell < 0 || cell >= board.Size() || degree < 0 ||
+            AddNode(cell) != n) {
+          Clear();
+          return false;
+        }
+        for (int k = 0; k < degree; k++) {
+          Edge e{};
+          if (!Read(file, e.to) || !Read(file, e.cost) || e.to < 0 || e.to >= count) {
+            Clear();
+            return false;
+          }
+          edges[n].push_back(e);
+        }
+      }
+      return true;
+    }
+
+    /**
+     * Find a path from init to goal through the abstract graph.
+     * Returns the cells on the path from init to goal inclusive, or an empty
+     * vector if goal can't be reached.
+     */
+    std::vector<Point> Search(int init[2], int goal[2]) {
+      std::vector<Point> path{};
+      if (!Passable(init[0], init[1]) || !Passable(goal[0], goal[1]))
+        return path;
+      int s = board.Index(init[0], init[1]);
+      int t = board.Index(goal[0], goal[1]);
+      if (s == t)
+        return std::vector<Point>{Point{init[0], init[1]}};
+
+      // Splice the endpoints into the graph, then take them out again.
+      int real_nodes = NodeCount();
+      std::vector<int> touched{};
+      int s_node = InsertEndpoint(s, touched);
+      int t_node = InsertEndpoint(t, touched);
+      std::vector<int> route = AbstractSearch(s_node, t_node);
+      for (auto it = touched.rbegin(); it != touched.rend(); ++it)
+        edges[*it].pop_back();
+      while (NodeCount() > real_nodes)
+        RemoveLastNode();
+
+      if (route.empty())
+        return path;
+      path.push_back(Point{init[0], init[1]});
+      for (size_t k = 1; k < route.size(); k++)
+        Refine(route[k - 1], route[k], path);
+      return path;
+    }
+
+    std::vector<Point> Search(Point init, Point goal) {
+      int i[2]{init.x, init.y};
+      int g[2]{goal.x, goal.y};
+      return Search(i, g);
+    }
+
+  private:
+    struct Edge {
+      int to;
+      int cost;
+    };
+
+    static constexpr uint32_t kMagic = 0x31415048;  // "HPA1"
+    static constexpr uint32_t kVersion = 1;
+    // Border runs shorter than this get one entrance in the middle, longer
+    // runs get one at each end.
+    static constexpr int kLongEntrance = 6;
+
+    const Grid &board;
+    int cluster_size;
+    int cluster_rows;
+    int cluster_cols;
+    std::vector<int> node_cells;                  // board index of each abstract node
+    std::vector<std::vector<Edge>> edges;
+    std::unordered_map<int, int> node_at;         // board index -> abstract node
+    std::vector<std::vector<int>> cluster_nodes;  // abstract nodes in each cluster
+    std::vector<int> local_dist;                  // BFS scratch, one cluster in size
+    std::vector<int> local_parent;
+
+    void Clear() {
+      node_cells.clear();
+      edges.clear();
+      node_at.clear();
+      cluster_nodes.assign(cluster_rows * cluster_cols, std::vector<int>{});
+    }
+
+    bool Passable(int x, int y) const {
+      bool on_grid_x = (x >= 0 && x < board.Height());
+      bool on_grid_y = (y >= 0 && y < board.Width());
+      return on_grid_x && on_grid_y && board(x, y) != State::kObstacle;
+    }
+
+    int ClusterOf(int cell) const {
+      return (cell / board.Width()) / cluster_size * cluster_cols + (cell % board.Width()) / cluster_size;
+    }
+
+    int AddNode(int cell) {
+      auto found = node_at.find(cell);
+      if (found != node_at.end())
+        return found->second;
+      int n = NodeCount();
+      node_cells.push_back(cell);
+      edges.push_back(std::vector<Edge>{});
+      node_at[cell] = n;
+      cluster_nodes[ClusterOf(cell)].push_back(n);
+      return n;
+    }
+
+    void RemoveLastNode() {
+      int cell = node_cells.back();
+      cluster_nodes[ClusterOf(cell)].pop_back();
+      node_at.erase(cell);
+      edges.pop_back();
+      node_cells.pop_back();
+    }
+
+    /**
+     * Scan length cells of one cluster border starting at (x, y) and stepping
+     * by (sx, sy). (ox, oy) points across the border into the neighbour.
+     */
+    void AddEntrances(int x, int y, int sx, int sy, int length, int ox, int oy) {
+      int run = 0;
+      for (int k = 0; k <= length; k++) {
+        int bx = x + k * sx;
+        int by = y + k * sy;
+        if (k < length && Passable(bx, by) && Passable(bx + ox, by + oy)) {
+          run++;
+          continue;
+        }
+        if (run > 0) {
+          int first = k - run;
+          int last = k - 1;
+          if (run < kLongEntrance) {
+            AddTransition(x + (first + last) / 2 * sx, y + (first + last) / 2 * sy, ox, oy);
+          } else {
+            AddTransition(x + first * sx, y + first * sy, ox, oy);
+            AddTransition(x + last * sx, y + last * sy, ox, oy);
+          }
+        }
+        run = 0;
+      }
+    }
+
+    void AddTransition(int x, int y, int ox, int oy) {
+      int a = AddNode(board.Index(x, y));
+      int b = AddNode(board.Index(x + ox, y + oy));
+      edges[a].push_back(Edge{b, 1});
+      edges[b].push_back(Edge{a, 1});
+    }
+
+    /**
+     * Breadth-first search from cell inside its own cluster. Fills local_dist
+     * and local_parent, indexed by position within the cluster.
+     */
+    void LocalBfs(int cell) {
+      int w = board.Width();
+      int x0 = (cell / w) / cluster_size * cluster_size;
+      int y0 = (cell % w) / cluster_size * cluster_size;
+      int x1 = std::min(x0 + cluster_size, board.Height());
+      int y1 = std::min(y0 + cluster_size, w);
+      std::fill(local_dist.begin(), local_dist.end(), -1);
+
+      std::vector<int> queue{cell};
+      local_dist[Local(cell)] = 0;
+      local_parent[Local(cell)] = -1;
+      for (size_t head = 0; head < queue.size(); head++) {
+        int c = queue[head];
+        for (int d = 0; d < 4; d++) {
+          int x2 = c / w + delta[d][0];
+          int y2 = c % w + delta[d][1];
+          if (x2 < x0 || x2 >= x1 || y2 < y0 || y2 >= y1 || !Passable(x2, y2))
+            continue;
+          int next = board.Index(x2, y2);
+          if (local_dist[Local(next)] != -1)
+            continue;
+          local_dist[Local(next)] = local_dist[Local(c)] + 1;
+          local_parent[Local(next)] = c;
+          queue.push_back(next);
+        }
+      }
+    }
+
+    // Entries Local can return: rows of the tallest cluster times cluster_size.
+    size_t LocalSize() const { return size_t(std::min(cluster_size, board.Height())) * cluster_size; }
+
+    int Local(int cell) const {
+      int w = board.Width();
+      return (cell / w) % cluster_size * cluster_size + (cell % w) % cluster_size;
+    }
+
+    /**
+     * Join node a to every other node in its cluster that it can reach.
+     * With both_ways the reverse edges are added too and their owners are
+     * recorded in touched so they can be removed later.
+     */
+    void ConnectInCluster(int a, const std::vector<int> &nodes, bool both_ways, std::vector<int> *touched = nullptr) {
+      LocalBfs(node_cells[a]);
+      for (int b : nodes) {
+        int dist = local_dist[Local(node_cells[b])];
+        if (b == a || dist == -1)
+          continue;
+        edges[a].push_back(Edge{b, dist});
+        if (both_ways) {
+          edges[b].push_back(Edge{a, dist});
+          touched->push_back(b);
+        }
+      }
+    }
+
+    int InsertEndpoint(int cell, std::vector<int> &touched) {
+      if (node_at.count(cell))
+        return node_at[cell];
+      int n = AddNode(cell);
+      ConnectInCluster(n, cluster_nodes[ClusterOf(cell)], true, &touched);
+      return n;
+    }
+
+    // A* over the abstract graph, returns the nodes from s to t.
+    std::vector<int> AbstractSearch(int s, int t) {
+      int w = board.Width();
+      int tx = node_cells[t] / w;
+      int ty = node_cells[t] % w;
+      auto h = [&](int n) { return Heuristic(node_cells[n] / w, node_cells[n] % w, tx, ty); };
+
+      std::vector<int> g_score(NodeCount(), -1);
+      std::vector<int> parent(NodeCount(), -1);
+      std::vector<bool> closed(NodeCount(), false);
+      typedef std::pair<int, int> Entry;  // (f, node)
+      std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>> open;
+      g_score[s] = 0;
+      open.push({h(s), s});
+      while (!open.empty()) {
+        int n = open.top().second;
+        open.pop();
+        if (closed[n])
+          continue;
+        closed[n] = true;
+        if (n == t)
+          break;
+        for (auto &e : edges[n]) {
+          int g2 = g_score[n] + e.cost;
+          if (closed[e.to] || (g_score[e.to] != -1 && g_score[e.to] <= g2))
+            continue;
+          g_score[e.to] = g2;
+          parent[e.to] = n;
+          open.push({g2 + h(e.to), e.to});
+        }
+      }
+
+      std::vector<int> route{};
+      if (!closed[t])
+        return route;
+      for (int n = t; n != -1; n = parent[n])
+        route.push_back(n);
+      std::reverse(route.begin(), route.end());
+      return route;
+    }
+
+    // Append the cells after node a up to and including node b.
+    void Refine(int a, int b, std::vector<Point> &path) {
+      int w = board.Width();
+      int from = node_cells[a];
+      int to = node_cells[b];
+      if (ClusterOf(from) != ClusterOf(to)) {
+        path.push_back(Point{to / w, to % w});
+        return;
+      }
+      LocalBfs(from);
+      size_t end = path.size();
+      for (int c = to; c != from; c = local_parent[Local(c)])
+        path.push_back(Point{c / w, c % w});
+      std::reverse(path.begin() + end, path.end());
+    }
+
+    // FNV-1a over the obstacle layout, to spot a file built for another board.
+    uint64_t BoardHash() const {
+      uint64_t hash = 14695981039346656037ull;
+      for (int x = 0; x < board.Height(); x++) {
+        for (int y = 0; y < board.Width(); y++) {
+          hash ^= board(x, y) == State::kObstacle ? 1 : 0;
+          hash *= 1099511628211ull;
+        }
+      }
+      return hash;
+    }
+
+    template <typename T>
+    static void Write(std::ofstream &file, const T &value) {
+      file.write(reinterpret_cast<const char *>(&value), sizeof(value));
+    }
+
+    template <typename T>
+    static bool Read(std::ifstream &file, T &value) {
+      return bool(file.read(reinterpret_cast<char *>(&value), sizeof(value)));
+    }
+};
+
+#endif
@@ -0,0 +1,157 @@
+#ifndef IDA_STAR_H
+#define IDA_STAR_H
+
+#include <climits>  // for INT_MAX
+#include <cstdint>
+#include <unordered_set>
+#include "astar.h"
+
+
+/**
+ * Iterative deepening A* for when the open list of SearchContext doesn't fit.
+ * Each iteration is a depth-first search that gives up on any path whose f
+ * goes over a bound. The next bound is the lowest f that went over. Memory is
+ * the current path plus a fixed-size transposition table, which remembers the
+ * lowest g each cell was reached with in this iteration so that the same
+ * subtree isn't searched again from a worse g. The table is lossy: a cell
+ * that collides with another just gets searched again. A bigger table means
+ * fewer repeated expansions, and a table of 0 entries is plain IDA*, which
+ * can take exponential time on open boards. Proving that the goal can't be
+ * reached is the worst case, since every iteration explores everything
+ * reachable.
+ */
+template <typename Stats = NoStats>
+class IdaSearchContext {
+  public:
+    IdaSearchContext(const Grid &board, size_t table_entries = 4096)
+        : board(board), table(table_entries), iteration(0) {}
+
+    const Stats &LastStats() const { return stats; }
+
+    // Bytes of the transposition table, the only memory not tied to the path.
+    size_t Bytes() const { return table.size() * sizeof(TableEntry); }
+
+    /**
+     * Find a shortest path from init to goal.
+     * Returns the cells on the path from init to goal inclusive, or an empty
+     * vector if goal can't be reached.
+     */
+    std::vector<Point> Search(int init[2], int goal[2]) {
+      stats.Begin();
+      std::vector<Point> path = Run(init, goal);
+      stats.End();
+      return path;
+    }
+
+  private:
+    struct Frame {
+      int x;
+      int y;
+      int g;
+      int next;         // index into order of the next move to try
+      uint8_t order[4];  // moves into delta, most promising first
+    };
+
+    struct TableEntry {
+      int cell = -1;
+      int g = 0;
+      unsigned iteration = 0;
+    };
+
+    const Grid &board;
+    std::vector<TableEntry> table;
+    unsigned iteration;
+    std::vector<Frame> stack;
+    std::unordered_set<int> on_path;
+    Stats stats;
+
+    std::vector<Point> Run(int init[2], int goal[2]) {
+      std::vector<Point> path{};
+      if (!CheckValidCell(init[0], init[1], board) || !CheckValidCell(goal[0], goal[1], board))
+        return path;
+      if (init[0] == goal[0] && init[1] == goal[1])
+        return std::vector<Point>{Point{init[0], init[1]}};
+
+      stats.HeuristicCall();
+      int bound = Heuristic(init[0], init[1], goal[0], goal[1]);
+      while (true) {
+        NextIteration();
+        int next_bound = INT_MAX;
+        stack.clear();
+        on_path.clear();
+        PushFrame(init[0], init[1], 0, goal);
+        while (!stack.empty()) {
+          Frame &top = stack.back();
+          if (top.next == 4) {
+            on_path.erase(board.Index(top.x, top.y));
+            stack.pop_back();
+            continue;
+          }
+          int d = top.order[top.next++];
+          int x2 = top.x + delta[d][0];
+          int y2 = top.y + delta[d][1];
+          int g2 = top.g + 1;
+          if (!CheckValidCell(x2, y2, board) || on_path.count(board.Index(x2, y2)))
+            continue;
+          stats.HeuristicCall();
+          int f = g2 + Heuristic(x2, y2, goal[0], goal[1]);
+          if (f > bound) {
+            next_bound = std::min(next_bound, f);
+            continue;
+          }
+          if (x2 == goal[0] && y2 == goal[1]) {
+            for (auto &frame : stack)
+              path.push_back(Point{frame.x, frame.y});
+            path.push_back(Point{x2, y2});
+            return path;
+          }
+          if (Dominated(board.Index(x2, y2), g2))
+            continue;
+          PushFrame(x2, y2, g2, goal);
+        }
+        if (next_bound == INT_MAX)
+          return path;
+        bound = next_bound;
+      }
+    }
+
+    void NextIteration() {
+      iteration++;
+      // Stamps wrapped around, old entries could look current again.
+      if (iteration == 0) {
+        std::fill(table.begin(), table.end(), TableEntry{});
+        iteration = 1;
+      }
+    }
+
+    // Expand (x, y): try its neighbours in order of their heuristic.
+    void PushFrame(int x, int y, int g, int goal[2]) {
+      Frame frame{x, y, g, 0, {0, 1, 2, 3}};
+      int h[4];
+      for (int d = 0; d < 4; d++) {
+        stats.HeuristicCall();
+        h[d] = Heuristic(x + delta[d][0], y + delta[d][1], goal[0], goal[1]);
+      }
+      std::sort(frame.order, frame.order + 4, [&](uint8_t a, uint8_t b) { return h[a] < h[b]; });
+      stack.push_back(frame);
+      on_path.insert(board.Index(x, y));
+      stats.Expand();
+      stats.Push(false, stack.size());
+    }
+
+    /**
+     * True if cell was already reached with a g no worse in this iteration.
+     * Otherwise records g for cell, replacing whatever shared its slot.
+     */
+    bool Dominated(int cell, int g) {
+      if (table.empty())
+        return false;
+      TableEntry &entry = table[uint32_t(cell) * 2654435761u % table.size()];
+      if (entry.iteration == iteration && entry.cell == cell && entry.g <= g)
+        return true;
+      entry = TableEntry{cell, g, iteration};
+      return false;
+    }
+};
+
+#endif
@@ -0,0 +1,181 @@
+#ifndef LANDMARKS_H
+#define LANDMARKS_H
+
+#include <atomic>
+#include <cstdint>
+#include <thread>
+#include "astar.h"
+
+
+/**
+ * Landmark (ALT) distance tables for one board. Every landmark has a
+ * 4-connected BFS distance to every cell. By the triangle inequality
+ * |d(L, a) - d(L, b)| is a lower bound on d(a, b) for any landmark L, which
+ * on maze-like boards is far tighter than Manhattan distance. Distances are
+ * stored as 16 bits per landmark per cell, with the values for one cell next
+ * to each other so a heuristic lookup touches one cache line. Distances that
+ * don't fit are stored as kSaturated: a clamped distance still changes by at
+ * most 1 per step, so the bound stays consistent. Cells a landmark can't
+ * reach are stored as kUnknown and give no bound.
+ */
+class Landmarks {
+  public:
+    static constexpr uint16_t kUnknown = 0xFFFF;
+    static constexpr uint16_t kSaturated = 0xFFFE;
+
+    // Spread count landmarks around the edge of the board.
+    Landmarks(const Grid &board, int count = 8, int workers = 0) : Landmarks(board, PickCells(board, count), workers) {}
+
+    /**
+     * Use the given open cells as landmarks. The distance fields are built on
+     * up to workers threads, one field per thread at a time; workers <= 0 uses
+     * one per core.
+     */
+    Landmarks(const Grid &board, const std::vector<Point> &cells, int workers = 0)
+        : width(board.Width()), cells(cells), distances(size_t(board.Size()) * cells.size(), kUnknown) {
+      int count = cells.size();
+      if (workers <= 0)
+        workers = std::max(1u, std::thread::hardware_concurrency());
+      workers = std::min(workers, count);
+
+      std::atomic<int> next{0};
+      auto work = [&]() {
+        std::vector<uint16_t> field;
+        std::vector<int> queue;
+        for (int l = next++; l < count; l = next++) {
+          DistanceField(board, cells[l], field, queue);
+          for (int i = 0; i < board.Size(); i++)
+            distances[size_t(i) * count + l] = field[i];
+        }
+      };
+      std::vector<std::thread> threads;
+      for (int i = 1; i < workers; i++)
+        threads.emplace_back(work);
+      if (workers > 0)
+        work();
+      for (auto &t : threads)
+        t.join();
+    }
+
+    int Count() const { return cells.size(); }
+    const std::vector<Point> &Cells() const { return cells; }
+    size_t Bytes() const { return distances.size() * sizeof(uint16_t); }
+
+    // Distances from every landmark to the cell at board index i.
+    const uint16_t *At(int i) const { return distances.data() + size_t(i) * cells.size(); }
+
+    /**
+     * Lower bound on the 4-connected distance between (x, y) and (goal_x,
+     * goal_y). Never less than the Manhattan distance.
+     */
+    int Heuristic(int x, int y, int goal_x, int goal_y) const {
+      int h = ::Heuristic(x, y, goal_x, goal_y);
+      const uint16_t *here = At(x * width + y);
+      const uint16_t *goal = At(goal_x * width + goal_y);
+      for (size_t l = 0; l < cells.size(); l++) {
+        if (here[l] != kUnknown && goal[l] != kUnknown)
+          h = std::max(h, std::abs(int(here[l]) - int(goal[l])));
+      }
+      return h;
+    }
+
+  private:
+    int width;
+    std::vector<Point> cells;
+    std::vector<uint16_t> distances;  // cell-major: distances[i * Count() + l]
+
+    /**
+     * Open cells nearest to count points spaced evenly along the board edge.
+     * Landmarks behind the goal, seen from the start, give the best bounds,
+     * and cells on the edge are behind most others.
+     */
+    static std::vector<Point> PickCells(const Grid &board, int count) {
+      std::vector<Point> picked{};
+      int h = board.Height();
+      int w = board.Width();
+      int perimeter = h > 1 && w > 1 ? 2 * (h + w) - 4 : h * w;
+      for (int k = 0; k < count && perimeter > 0; k++) {
+        // Walk clockwise from the top-left corner.
+        int t = int(int64_t(k) * perimeter / count);
+        Point target{};
+        if (t < w)
+          target = Point{0, t};
+        else if (t < w + h - 1)
+          target = Point{t - w + 1, w - 1};
+        else if (t < 2 * w + h - 2)
+          target = Point{h - 1, w - 1 - (t - w - h + 2)};
+        else
+          target = Point{h - 1 - (t - 2 * w - h + 3), 0};
+        Point cell{};
+        if (NearestOpen(board, target, cell) && std::find(picked.begin(), picked.end(), cell) == picked.end())
+          picked.push_back(cell);
+      }
+      return picked;
+    }
+
+    // Search outward in Manhattan rings from target for an open cell.
+    static bool NearestOpen(const Grid &board, Point target, Point &cell) {
+      int h = board.Height();
+      int w = board.Width();
+      for (int r = 0; r < h + w; r++) {
+        for (int dx = -r; dx <= r; dx++) {
+          int dy = r - std::abs(dx);
+          for (int side = -1; side <= 1; side += 2) {
+            int x = target.x + dx;
+            int y = target.y + side * dy;
+            if (x >= 0 && x < h && y >= 0 && y < w && board(x, y) != State::kObstacle) {
+              cell = Point{x, y};
+              return true;
+            }
+            if (dy == 0)
+              break;
+          }
+        }
+      }
+      return false;
+    }
+
+    // Breadth-first distances from source over open cells.
+    static void DistanceField(const Grid &board, Point source, std::vector<uint16_t> &field, std::vector<int> &queue) {
+      field.assign(board.Size(), kUnknown);
+      queue.clear();
+      int w = board.Width();
+      field[board.Index(source.x, source.y)] = 0;
+      queue.push_back(board.Index(source.x, source.y));
+      for (size_t head = 0; head < queue.size(); head++) {
+        int i = queue[head];
+        uint16_t next = std::min<int>(field[i] + 1, kSaturated);
+        for (int d = 0; d < 4; d++) {
+          int x2 = i / w + delta[d][0];
+          int y2 = i % w + delta[d][1];
+          if (x2 < 0 || x2 >= board.Height() || y2 < 0 || y2 >= w || board(x2, y2) == State::kObstacle)
+            continue;
+          int j = board.Index(x2, y2);
+          if (field[j] == kUnknown) {
+            field[j] = next;
+            queue.push_back(j);
+          }
+        }
+      }
+    }
+};
+
+
+/**
+ * Heuristic policy for BasicSearchContext that takes the bound from
+ * Landmarks. The distances are 4-connected steps, so it only fits
+ * FourConnected. The landmarks must outlive the context.
+ */
+struct LandmarkHeuristic {
+  const Landmarks *landmarks;
+
+  LandmarkHeuristic(const Landmarks &landmarks) : landmarks(&landmarks) {}
+
+  int Heuristic(int x, int y, int goal_x, int goal_y) const { return landmarks->Heuristic(x, y, goal_x, goal_y); }
+};
+
+// A* with landmark bounds: every mode and query of SearchContext, plus Stats.
+template <typename Stats = NoStats>
+using LandmarkSearchContext = BasicSearchContext<FourConnected, Stats, LandmarkHeuristic>;
+
+#endif
@@ -1,29 +1,48 @@
-void PrintVector(vector<int> v) {
-  cout << "{ ";
-  for (auto item : v) {
-    cout << item << " ";
+void PrintNode(const Node &n) {
+  cout << "{ " << n.x << " " << n.y << " " << n.g << " " << n.h << " }" << "\n";
+}
+
+void PrintOpenList(const vector<Node> &v) {
+  for (auto &n : v) {
+    PrintNode(n);
   }
-  cout << "}" << "\n";
 }
 
-void PrintVectorOfVectors(vector<vector<int>> v) {
-  for (auto row : v) {
+void PrintVectorOfVectors(const Grid &grid) {
+  for (int i = 0; i < grid.Height(); i++) {
     cout << "{ ";
-    for (auto col : row) {
-      cout << col << " ";
+    for (int j = 0; j < grid.Width(); j++) {
+      cout << CellString(grid(i, j)) << " ";
     }
     cout << "}" << "\n";
   }
 }
 
-void PrintVectorOfVectors(vector<vector<State>> v) {
-  for (auto row : v) {
-    cout << "{ ";
-    for (auto col : row) {
-      cout << CellString(col) << " ";
-    }
-    cout << "}" << "\n";
+void TestReadBoardFile() {
+  cout << "----------------------------------------------------------" << "\n";
+  cout << "ReadBoardFile Function Test: ";
+  auto board = ReadBoardFile("files/1.board");
+  Grid solution = vector<vector<State>>{{State::kEmpty, State::kObstacle, State::kEmpty, State::kEmpty, State::kEmpty, State::kEmpty},
+                            {State::kEmpty, State::kObstacle, State::kEmpty, State::kEmpty, State::kEmpty, State::kEmpty},
+                            {State::kEmpty, State::kObstacle, State::kEmpty, State::kEmpty, State::kEmpty, State::kEmpty},
+                            {State::kEmpty, State::kObstacle, State::kEmpty, State::kEmpty, State::kEmpty, State::kEmpty},
+                            {State::kEmpty, State::kEmpty, State::kEmpty, State::kEmpty, State::kObstacle, State::kEmpty}};
+  if (board.Height() != 5 || board.Width() != 6) {
+    cout << "failed" << "\n";
+    cout << "\n" << "Board size is " << board.Height() << "x" << board.Width() << "\n";
+    cout << "Correct size: 5x6" << "\n";
+    cout << "\n";
+  } else if (board != solution || board(4, 4) != State::kObstacle) {
+    cout << "failed" << "\n";
+    cout << "\n" << "Your board is: " << "\n";
+    PrintVectorOfVectors(board);
+    cout << "Solution board is: " << "\n";
+    PrintVectorOfVectors(solution);
+    cout << "\n";
+  } else {
+    cout << "passed" << "\n";
   }
+  return;
 }
 
 void TestHeuristic() {
@@ -52,24 +71,24 @@ void TestAddToOpen() {
   int y = 0;
   int g = 5;
   int h = 7;
-  vector<vector<int>> open{{0, 0, 2, 9}, {1, 0, 2, 2}, {2, 0, 2, 4}};
-  vector<vector<int>> solution_open = open; 
-  solution_open.push_back(vector<int>{3, 0, 5, 7});
-  vector<vector<State>> grid{{State::kClosed, State::kObstacle, State::kEmpty, State::kEmpty, State::kEmpty, State::kEmpty},
+  vector<Node> open{{0, 0, 2, 9}, {1, 0, 2, 2}, {2, 0, 2, 4}};
+  vector<Node> solution_open = open; 
+  solution_open.push_back(Node{3, 0, 5, 7});
+  Grid grid = vector<vector<State>>{{State::kClosed, State::kObstacle, State::kEmpty, State::kEmpty, State::kEmpty, State::kEmpty},
                             {State::kClosed, State::kObstacle, State::kEmpty, State::kEmpty, State::kEmpty, State::kEmpty},
                             {State::kClosed, State::kObstacle, State::kEmpty, State::kEmpty, State::kEmpty, State::kEmpty},
                             {State::kEmpty, State::kObstacle, State::kEmpty, State::kEmpty, State::kEmpty, State::kEmpty},
                             {State::kEmpty, State::kEmpty, State::kEmpty, State::kEmpty, State::kObstacle, State::kEmpty}};
-  vector<vector<State>> solution_grid = grid;
-  solution_grid[3][0] = State::kClosed;
+  Grid solution_grid = grid;
+  solution_grid(3, 0) = State::kClosed;
   AddToOpen(x, y, g, h, open, grid);
   if (open != solution_open) {
     cout << "failed" << "\n";
     cout << "\n";
     cout << "Your open list is: " << "\n";
-    PrintVectorOfVectors(open);
+    PrintOpenList(open);
     cout << "Solution open list is: " << "\n";
-    PrintVectorOfVectors(solution_open);
+    PrintOpenList(solution_open);
     cout << "\n";
   } else if (grid != solution_grid) {
     cout << "failed" << "\n";
@@ -89,25 +108,25 @@ void TestAddToOpen() {
 void TestCompare() {
   cout << "----------------------------------------------------------" << "\n";
   cout << "Compare Function Test: ";
-  vector<int> test_1 {1, 2, 5, 6};
-  vector<int> test_2 {1, 3, 5, 7};
-  vector<int> test_3 {1, 2, 5, 8};
-  vector<int> test_4 {1, 3, 5, 7};
+  Node test_1 {1, 2, 5, 6};
+  Node test_2 {1, 3, 5, 7};
+  Node test_3 {1, 2, 5, 8};
+  Node test_4 {1, 3, 5, 7};
   if (Compare(test_1, test_2)) {
     cout << "failed" << "\n";
     cout << "\n" << "a = ";
-    PrintVector(test_1);
+    PrintNode(test_1);
     cout << "b = ";
-    PrintVector(test_2);
+    PrintNode(test_2);
     cout << "Compare(a, b): " << Compare(test_1, test_2) << "\n";
     cout << "Correct answer: 0" << "\n";
     cout << "\n";
   } else if (!Compare(test_3, test_4)) {
     cout << "failed" << "\n";
     cout << "\n" << "a = ";
-    PrintVector(test_3);
+    PrintNode(test_3);
     cout << "b = ";
-    PrintVector(test_4);
+    PrintNode(test_4);
     cout << "Compare(a, b): " << Compare(test_3, test_4) << "\n";
     cout << "Correct answer: 1" << "\n";
     cout << "\n";
@@ -117,6 +136,35 @@ void TestCompare() {
   return;
 }
 
+void TestPopFromOpen() {
+  cout << "----------------------------------------------------------" << "\n";
+  cout << "PopFromOpen Function Test: ";
+  vector<Node> open{};
+  Grid grid(5, 6);
+  AddToOpen(0, 0, 2, 9, open, grid);
+  AddToOpen(1, 0, 2, 2, open, grid);
+  AddToOpen(2, 0, 2, 4, open, grid);
+  AddToOpen(3, 0, 5, 7, open, grid);
+  AddToOpen(4, 0, 1, 5, open, grid);
+  vector<Node> solution_order{{1, 0, 2, 2}, {2, 0, 2, 4}, {4, 0, 1, 5}, {0, 0, 2, 9}, {3, 0, 5, 7}};
+  vector<Node> order{};
+  while (open.size() > 0) {
+    order.push_back(PopFromOpen(open));
+  }
+  if (order != solution_order) {
+    cout << "failed" << "\n";
+    cout << "\n";
+    cout << "Your pop order is: " << "\n";
+    PrintOpenList(order);
+    cout << "Solution pop order is: " << "\n";
+    PrintOpenList(solution_order);
+    cout << "\n";
+  } else {
+    cout << "passed" << "\n";
+  }
+  return;
+}
+
 void TestSearch() {
   cout << "----------------------------------------------------------" << "\n";
   cout << "Search Function Test: ";
@@ -128,10 +176,10 @@ void TestSearch() {
   auto output = Search(board, init, goal);
   std::cout.clear(); // Enable cout
 
-  vector<vector<State>> solution{{State::kStart, State::kObstacle, State::kEmpty, State::kEmpty, State::kEmpty, State::kEmpty},
+  Grid solution = vector<vector<State>>{{State::kStart, State::kObstacle, State::kEmpty, State::kEmpty, State::kEmpty, State::kEmpty},
+                            {State::kPath, State::kObstacle, State::kEmpty, State::kEmpty, State::kEmpty, State::kEmpty},
                             {State::kPath, State::kObstacle, State::kEmpty, State::kEmpty, State::kEmpty, State::kEmpty},
-                            {State::kPath, State::kObstacle, State::kEmpty, State::kClosed, State::kClosed, State::kClosed},
-                            {State::kPath, State::kObstacle, State::kClosed, State::kPath, State::kPath, State::kPath},
+                            {State::kPath, State::kObstacle, State::kEmpty, State::kPath, State::kPath, State::kPath},
                             {State::kPath, State::kPath, State::kPath, State::kPath, State::kObstacle, State::kFinish}};
 
   if (output != solution) {
@@ -151,7 +199,7 @@ void TestSearch() {
 void TestCheckValidCell() {
   cout << "----------------------------------------------------------" << "\n";
   cout << "CheckValidCell Function Test: ";
-  vector<vector<State>> grid{{State::kClosed, State::kObstacle, State::kEmpty, State::kEmpty, State::kEmpty, State::kEmpty},
+  Grid grid = vector<vector<State>>{{State::kClosed, State::kObstacle, State::kEmpty, State::kEmpty, State::kEmpty, State::kEmpty},
                             {State::kClosed, State::kObstacle, State::kEmpty, State::kEmpty, State::kEmpty, State::kEmpty},
                             {State::kClosed, State::kObstacle, State::kEmpty, State::kEmpty, State::kEmpty, State::kEmpty},
                             {State::kClosed, State::kObstacle, State::kEmpty, State::kEmpty, State::kEmpty, State::kEmpty},
@@ -177,20 +225,20 @@ void TestCheckValidCell() {
 void TestExpandNeighbors() {
   cout << "----------------------------------------------------------" << "\n";
   cout << "ExpandNeighbors Function Test: ";
-  vector<int> current{4, 2, 7, 3};
+  Node current{4, 2, 7, 3};
   int goal[2] {4, 5};
-  vector<vector<int>> open{{4, 2, 7, 3}};
-  vector<vector<int>> solution_open = open;
-  solution_open.push_back(vector<int>{3, 2, 8, 4});
-  solution_open.push_back(vector<int>{4, 3, 8, 2});
-  vector<vector<State>> grid{{State::kClosed, State::kObstacle, State::kEmpty, State::kEmpty, State::kEmpty, State::kEmpty},
+  vector<Node> open{{4, 2, 7, 3}};
+  vector<Node> solution_open = open;
+  solution_open.push_back(Node{3, 2, 8, 4});
+  solution_open.push_back(Node{4, 3, 8, 2});
+  Grid grid = vector<vector<State>>{{State::kClosed, State::kObstacle, State::kEmpty, State::kEmpty, State::kEmpty, State::kEmpty},
                             {State::kClosed, State::kObstacle, State::kEmpty, State::kEmpty, State::kEmpty, State::kEmpty},
                             {State::kClosed, State::kObstacle, State::kEmpty, State::kEmpty, State::kEmpty, State::kEmpty},
                             {State::kClosed, State::kObstacle, State::kEmpty, State::kEmpty, State::kEmpty, State::kEmpty},
                             {State::kClosed, State::kClosed, State::kEmpty, State::kEmpty, State::kObstacle, State::kEmpty}};
-  vector<vector<State>> solution_grid = grid;
-  solution_grid[3][2] = State::kClosed;
-  solution_grid[4][3] = State::kClosed;
+  Grid solution_grid = grid;
+  solution_grid(3, 2) = State::kClosed;
+  solution_grid(4, 3) = State::kClosed;
   ExpandNeighbors(current, goal, open, grid);
   CellSort(&open);
   CellSort(&solution_open);
@@ -198,9 +246,9 @@ void TestExpandNeighbors() {
     cout << "failed" << "\n";
     cout << "\n";
     cout << "Your open list is: " << "\n";
-    PrintVectorOfVectors(open);
+    PrintOpenList(open);
     cout << "Solution open list is: " << "\n";
-    PrintVectorOfVectors(solution_open);
+    PrintOpenList(solution_open);
     cout << "\n";
   } else if (grid != solution_grid) {
     cout << "failed" << "\n";
@@ -214,6 +262,1440 @@ void TestExpandNeighbors() {
   } else {
   	cout << "passed" << "\n";
   }
+  return;
+}
+
+void PrintPath(const vector<Point> &path, std::ostream &out = cout) {
+  out << "{ ";
+  for (auto &p : path) {
+    out << "(" << p.x << ", " << p.y << ") ";
+  }
+  out << "}" << "\n";
+}
+
+// A path is valid if it runs from init to goal in single steps over open cells.
+bool CheckPath(const vector<Point> &path, int init[2], int goal[2], const Grid &grid) {
+  if (path.empty() || path.front() != Point{init[0], init[1]} || path.back() != Point{goal[0], goal[1]})
+    return false;
+  for (size_t i = 0; i < path.size(); i++) {
+    if (grid(path[i].x, path[i].y) == State::kObstacle)
+      return false;
+    if (i > 0 && Heuristic(path[i - 1].x, path[i - 1].y, path[i].x, path[i].y) != 1)
+      return false;
+  }
+  return true;
+}
+
+/**
+ * Compare a search under test with SearchContext on seeded random boards.
+ * For each seed, setup(board, seed, rng) builds the search for the board,
+ * and may swap in another board first. Then 25 queries, the first with init
+ * == goal, go to check(board, init, goal, shortest, why), where shortest is
+ * SearchContext's path. check returns false and explains in why if the search
+ * got it wrong. Prints the first failure and returns the number of failures.
+ */
+template <typename Setup, typename Check>
+int CompareOnRandomBoards(int height, int width, unsigned seeds, Setup setup, Check check) {
+  for (unsigned seed = 1; seed <= seeds; seed++) {
+    Grid board = GenerateRandomBoard(height, width, seed % 4 * 10, seed);
+    std::mt19937 rng(seed);
+    setup(board, seed, rng);
+    SearchContext context(board);
+    for (int q = 0; q < 25; q++) {
+      int init[2]{int(rng() % board.Height()), int(rng() % board.Width())};
+      int goal[2]{int(rng() % board.Height()), int(rng() % board.Width())};
+      if (q == 0) {
+        goal[0] = init[0];
+        goal[1] = init[1];
+      }
+      auto shortest = context.Search(init, goal);
+      std::ostringstream why;
+      if (!check(board, init, goal, shortest, why)) {
+        cout << "failed" << "\n";
+        cout << "\n" << "Board seed " << seed << ", query (" << init[0] << ", " << init[1] << ") to ("
+             << goal[0] << ", " << goal[1] << ")" << "\n";
+        cout << why.str();
+        cout << "\n";
+        return 1;
+      }
+    }
+  }
+  return 0;
+}
+
+void TestSearchContext() {
+  cout << "----------------------------------------------------------" << "\n";
+  cout << "SearchContext Test: ";
+  int init[2]{0, 0};
+  int goal[2]{4, 5};
+  int blocked[2]{0, 1};
+  auto board = ReadBoardFile("files/1.board");
+  Grid solution_board = board;
+  SearchContext context(board);
+
+  auto path = context.Search(init, goal);
+  auto reverse_path = context.Search(goal, init);
+  auto no_path = context.Search(init, blocked);
+  auto path_again = context.Search(init, goal);
+
+  if (!CheckPath(path, init, goal, board) || path.size() != 12) {
+    cout << "failed" << "\n";
+    cout << "\n" << "context.Search({0,0}, {4,5}) = ";
+    PrintPath(path);
+    cout << "Correct result: 12 cells from (0, 0) to (4, 5)" << "\n";
+    cout << "\n";
+  } else if (!CheckPath(reverse_path, goal, init, board) || reverse_path.size() != 12) {
+    cout << "failed" << "\n";
+    cout << "\n" << "context.Search({4,5}, {0,0}) = ";
+    PrintPath(reverse_path);
+    cout << "Correct result: 12 cells from (4, 5) to (0, 0)" << "\n";
+    cout << "\n";
+  } else if (!no_path.empty()) {
+    cout << "failed" << "\n";
+    cout << "\n" << "context.Search({0,0}, {0,1}) = ";
+    PrintPath(no_path);
+    cout << "Correct result: {}" << "\n";
+    cout << "\n";
+  } else if (path_again != path) {
+    cout << "failed" << "\n";
+    cout << "\n" << "Repeated query returned ";
+    PrintPath(path_again);
+    cout << "Correct result: ";
+    PrintPath(path);
+    cout << "\n";
+  } else if (board != solution_board) {
+    cout << "failed" << "\n";
+    cout << "\n" << "Board was modified by the search: " << "\n";
+    PrintVectorOfVectors(board);
+    cout << "\n";
+  } else {
+    cout << "passed" << "\n";
+  }
+  return;
+}
+
+void TestPathToDirections() {
+  cout << "----------------------------------------------------------" << "\n";
+  cout << "PathToDirections Function Test: ";
+  vector<Point> path{{0, 0}, {1, 0}, {2, 0}, {3, 0}, {4, 0}, {4, 1}, {4, 2}, {4, 3},
+                     {3, 3}, {3, 4}, {3, 5}, {4, 5}};
+  string solution = "D4R3U1R2D1";
+  string directions = PathToDirections(path);
+  auto decoded = DirectionsToPath(path.front(), directions);
+  if (directions != solution) {
+    cout << "failed" << "\n";
+    cout << "\n" << "PathToDirections(path) = " << directions << "\n";
+    cout << "Correct result: " << solution << "\n";
+    cout << "\n";
+  } else if (decoded != path) {
+    cout << "failed" << "\n";
+    cout << "\n" << "DirectionsToPath({0, 0}, " << directions << ") = ";
+    PrintPath(decoded);
+    cout << "Correct result: ";
+    PrintPath(path);
+    cout << "\n";
+  } else if (PathToDirections(vector<Point>{{2, 2}}) != "") {
+    cout << "failed" << "\n";
+    cout << "\n" << "PathToDirections({(2, 2)}) should be empty" << "\n";
+    cout << "\n";
+  } else {
+    cout << "passed" << "\n";
+  }
+  return;
+}
+
+void TestSearchBatch() {
+  cout << "----------------------------------------------------------" << "\n";
+  cout << "SearchBatch Function Test: ";
+  auto board = ReadBoardFile("files/1.board");
+  vector<Query> queries{};
+  for (int x = 0; x < board.Height(); x++)
+    for (int y = 0; y < board.Width(); y++)
+      queries.push_back(Query{Point{0, 0}, Point{x, y}});
+  queries.push_back(Query{Point{4, 5}, Point{0, 0}});
+
+  SearchContext context(board);
+  vector<vector<Point>> solution{};
+  for (auto &q : queries)
+    solution.push_back(context.Search(q.init, q.goal));
+  auto results = SearchBatch(board, queries, 4);
+  auto empty = SearchBatch(board, vector<Query>{}, 4);
+
+  size_t wrong = 0;
+  while (wrong < queries.size() && wrong < results.size() && results[wrong] == solution[wrong])
+    wrong++;
+  if (results.size() != queries.size()) {
+    cout << "failed" << "\n";
+    cout << "\n" << "SearchBatch returned " << results.size() << " results" << "\n";
+    cout << "Correct result: " << queries.size() << "\n";
+    cout << "\n";
+  } else if (wrong != queries.size()) {
+    cout << "failed" << "\n";
+    cout << "\n" << "Query " << wrong << " returned ";
+    PrintPath(results[wrong]);
+    cout << "Correct result: ";
+    PrintPath(solution[wrong]);
+    cout << "\n";
+  } else if (!empty.empty()) {
+    cout << "failed" << "\n";
+    cout << "\n" << "SearchBatch with no queries returned results" << "\n";
+    cout << "\n";
+  } else {
+    cout << "passed" << "\n";
+  }
+  return;
+}
+
+void TestJumpPointSearch() {
+  cout << "----------------------------------------------------------" << "\n";
+  cout << "Jump Point Search Test: ";
+  std::unique_ptr<SearchContext> context;
+  int failures = CompareOnRandomBoards(24, 32, 40,
+      [&](Grid &board, unsigned, std::mt19937 &) { context.reset(new SearchContext(board)); },
+      [&](const Grid &board, int init[2], int goal[2], const vector<Point> &shortest, std::ostream &why) {
+        auto jps_path = context->Search(init, goal, Expansion::kJumpPoints);
+        why << "Jump point path: ";
+        PrintPath(jps_path, why);
+        why << "Correct length: " << shortest.size() << "\n";
+        return jps_path.size() == shortest.size() && (jps_path.empty() || CheckPath(jps_path, init, goal, board));
+      });
+
+  // The jump tables follow edits to the board.
+  Grid board(5, 9);
+  SearchContext edited(board);
+  int init[2]{2, 0};
+  int goal[2]{2, 8};
+  auto before = edited.Search(init, goal, Expansion::kJumpPoints);
+  for (int x = 0; x < 4; x++)
+    board.Set(x, 4, State::kObstacle);
+  auto after = edited.Search(init, goal, Expansion::kJumpPoints);
+  if (failures == 0 && (before.size() != 9 || after.size() != 13 || !CheckPath(after, init, goal, board))) {
+    cout << "failed" << "\n";
+    cout << "\n" << "Path after walling off column 4: ";
+    PrintPath(after);
+    cout << "Correct lengths: 9 before, 13 after" << "\n";
+    cout << "\n";
+    failures++;
+  }
+  if (failures == 0)
+    cout << "passed" << "\n";
+  return;
+}
+
+void TestBidirectionalSearch() {
+  cout << "----------------------------------------------------------" << "\n";
+  cout << "BidirectionalSearchContext Test: ";
+  std::unique_ptr<BidirectionalSearchContext> bidirectional;
+  int failures = CompareOnRandomBoards(24, 32, 40,
+      [&](Grid &board, unsigned, std::mt19937 &) { bidirectional.reset(new BidirectionalSearchContext(board)); },
+      [&](const Grid &board, int init[2], int goal[2], const vector<Point> &shortest, std::ostream &why) {
+        auto path = bidirectional->Search(init, goal);
+        why << "Bidirectional path: ";
+        PrintPath(path, why);
+        why << "Correct length: " << shortest.size() << "\n";
+        return path.size() == shortest.size() && (path.empty() || CheckPath(path, init, goal, board));
+      });
+  if (failures == 0)
+    cout << "passed" << "\n";
+  return;
+}
+
+void TestHierarchicalMap() {
+  cout << "----------------------------------------------------------" << "\n";
+  cout << "HierarchicalMap Test: ";
+  std::unique_ptr<HierarchicalMap> map;
+  int failures = CompareOnRandomBoards(40, 52, 20,
+      [&](Grid &board, unsigned, std::mt19937 &) {
+        map.reset(new HierarchicalMap(board, 8));
+        map->Build();
+      },
+      [&](const Grid &board, int init[2], int goal[2], const vector<Point> &shortest, std::ostream &why) {
+        auto hpa_path = map->Search(init, goal);
+        why << "HierarchicalMap path: ";
+        PrintPath(hpa_path, why);
+        why << "Shortest path: ";
+        PrintPath(shortest, why);
+        // Not always shortest, but never shorter and found whenever there is a path.
+        return hpa_path.empty() == shortest.empty() &&
+               (shortest.empty() || (CheckPath(hpa_path, init, goal, board) && hpa_path.size() >= shortest.size()));
+      });
+
+  // Save and load give the same answers, and a file for another board is rejected.
+  Grid board = GenerateRandomBoard(40, 52, 20, 7);
+  Grid other_board = GenerateRandomBoard(40, 52, 20, 8);
+  HierarchicalMap hpa(board, 8);
+  hpa.Build();
+  bool saved = hpa.Save("files/test.hpa");
+  HierarchicalMap loaded(board, 8);
+  HierarchicalMap other(other_board, 8);
+  bool loaded_ok = loaded.Load("files/test.hpa");
+  bool other_ok = other.Load("files/test.hpa");
+  std::remove("files/test.hpa");
+  bool same_answers = loaded.NodeCount() == hpa.NodeCount();
+  std::mt19937 rng(7);
+  for (int q = 0; q < 25 && same_answers; q++) {
+    int init[2]{int(rng() % 40), int(rng() % 52)};
+    int goal[2]{int(rng() % 40), int(rng() % 52)};
+    same_answers = hpa.Search(init, goal) == loaded.Search(init, goal);
+  }
+  if (failures == 0 && (!saved || !loaded_ok || other_ok || !same_answers)) {
+    cout << "failed" << "\n";
+    cout << "\n" << "Save: " << saved << ", Load: " << loaded_ok << ", Load for another board: " << other_ok
+         << ", same answers after Load: " << same_answers << "\n";
+    cout << "Correct result: 1, 1, 0, 1" << "\n";
+    cout << "\n";
+    failures++;
+  }
+
+  // Cluster sizes below 1 or beyond the board are clamped, not divided by.
+  SearchContext context(board);
+  for (int size : {0, -5, 1, 1000}) {
+    HierarchicalMap clamped(board, size);
+    clamped.Build();
+    for (int q = 0; q < 10 && failures == 0; q++) {
+      int init[2]{int(rng() % 40), int(rng() % 52)};
+      int goal[2]{int(rng() % 40), int(rng() % 52)};
+      auto path = clamped.Search(init, goal);
+      bool found = !context.Search(init, goal).empty();
+      if (path.empty() == found || (found && !CheckPath(path, init, goal, board))) {
+        cout << "failed" << "\n";
+        cout << "\n" << "Wrong path with cluster size " << size << "\n";
+        PrintPath(path);
+        cout << "\n";
+        failures++;
+      }
+    }
+  }
+  if (failures == 0)
+    cout << "passed" << "\n";
+  return;
+}
+
+void TestMapBoardFile() {
+  cout << "----------------------------------------------------------" << "\n";
+  cout << "MapBoardFile Function Test: ";
+  // Multi-digit values, spaces, CRLF, short and long rows, no final newline.
+  std::ofstream out("files/test.board");
+  out << "0,1,0,0,\n" << "0, 0 ,12,0,\r\n" << "0,0,\n" << "1,0,0,0,0,0,\n" << "\n" << "0,0,0,0";
+  out.close();
+  auto board = MapBoardFile("files/test.board");
+  auto solution = ReadBoardFile("files/test.board");
+  std::remove("files/test.board");
+  auto small_board = MapBoardFile("files/1.board");
+  auto small_solution = ReadBoardFile("files/1.board");
+  auto missing = MapBoardFile("files/missing.board");
+
+  if (board != solution) {
+    cout << "failed" << "\n";
+    cout << "\n" << "Your board is: " << "\n";
+    PrintVectorOfVectors(board);
+    cout << "Solution board is: " << "\n";
+    PrintVectorOfVectors(solution);
+    cout << "\n";
+  } else if (small_board != small_solution) {
+    cout << "failed" << "\n";
+    cout << "\n" << "MapBoardFile(\"files/1.board\") is: " << "\n";
+    PrintVectorOfVectors(small_board);
+    cout << "\n";
+  } else if (!missing.Empty()) {
+    cout << "failed" << "\n";
+    cout << "\n" << "MapBoardFile of a missing file should be empty" << "\n";
+    cout << "\n";
+  } else {
+    cout << "passed" << "\n";
+  }
+  return;
+}
+
+void TestBinaryBoard() {
+  cout << "----------------------------------------------------------" << "\n";
+  cout << "BinaryBoard Test: ";
+  Grid board = GenerateRandomBoard(7, 130, 30, 3);
+  vector<uint8_t> costs(board.Size());
+  for (int i = 0; i < board.Size(); i++)
+    costs[i] = i % 256;
+  bool written = WriteBinaryBoard(board, "files/test.bboard", &costs);
+  BinaryBoard binary("files/test.bboard");
+  bool costs_match = binary.HasCosts();
+  for (int x = 0; x < board.Height() && costs_match; x++)
+    for (int y = 0; y < board.Width(); y++)
+      costs_match = costs_match && binary.Cost(x, y) == costs[board.Index(x, y)];
+  Grid loaded = binary.ToGrid();
+
+  // Search straight on the mapping and on copies of its layers.
+  CostGrid cost_copy(binary);
+  SearchContext context(board);
+  BitSearchContext bit_context(binary);
+  WeightedSearchContext<> weighted(binary);
+  WeightedSearchContext<> weighted_copy(cost_copy);
+  bool searches_match = true;
+  std::mt19937 rng(7);
+  for (int q = 0; q < 25 && searches_match; q++) {
+    int init[2]{int(rng() % 7), int(rng() % 130)};
+    int goal[2]{int(rng() % 7), int(rng() % 130)};
+    auto path = weighted.Search(init, goal);
+    auto copy_path = weighted_copy.Search(init, goal);
+    searches_match = bit_context.Search(init, goal).size() == context.Search(init, goal).size() &&
+                     (path.empty() ? -1 : weighted.PathCost(path)) ==
+                         (copy_path.empty() ? -1 : weighted_copy.PathCost(copy_path));
+  }
+
+  // Cut the file short: the cost layer no longer fits.
+  std::ifstream in("files/test.bboard", std::ios::binary);
+  string bytes((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+  std::ofstream out("files/test.bboard", std::ios::binary | std::ios::trunc);
+  out.write(bytes.data(), bytes.size() - 10);
+  out.close();
+  BinaryBoard truncated("files/test.bboard");
+  BinaryBoard missing("files/missing.bboard");
+
+  // Headers whose sizes overflow int or 64-bit offset arithmetic.
+  auto corrupt = [&](void (*edit)(BinaryBoardHeader &)) {
+    BinaryBoardHeader header;
+    std::memcpy(&header, bytes.data(), sizeof(header));
+    edit(header);
+    std::ofstream out("files/test.bboard", std::ios::binary | std::ios::trunc);
+    out.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    out.write(bytes.data() + sizeof(header), bytes.size() - sizeof(header));
+    out.close();
+    return BinaryBoard("files/test.bboard").Valid();
+  };
+  int corrupt_valid = corrupt([](BinaryBoardHeader &h) { h.height = 0x80000000u; }) +
+                      corrupt([](BinaryBoardHeader &h) { h.width = 0xFFFFFFFFu; h.row_words = 0x4000000u; }) +
+                      corrupt([](BinaryBoardHeader &h) { h.height = 65536; h.width = 65536; h.row_words = 1024; }) +
+                      corrupt([](BinaryBoardHeader &h) { h.height = 0x40000000u; h.width = 1; h.row_words = 1; }) +
+                      corrupt([](BinaryBoardHeader &h) { h.obstacle_offset = ~uint64_t(63); }) +
+                      corrupt([](BinaryBoardHeader &h) { h.cost_offset = ~uint64_t(63); });
+  std::remove("files/test.bboard");
+
+  if (!written || !binary.Valid() || binary.Height() != 7 || binary.Width() != 130 || binary.RowWords() != 3) {
+    cout << "failed" << "\n";
+    cout << "\n" << "Binary board is " << binary.Height() << "x" << binary.Width() << ", valid: " << binary.Valid() << "\n";
+    cout << "Correct result: 7x130, valid: 1" << "\n";
+    cout << "\n";
+  } else if (loaded != board || !costs_match) {
+    cout << "failed" << "\n";
+    cout << "\n" << "Cells read back differ from the board written, costs match: " << costs_match << "\n";
+    cout << "\n";
+  } else if (!searches_match) {
+    cout << "failed" << "\n";
+    cout << "\n" << "Searches on the mapped board differ from searches on copies of it" << "\n";
+    cout << "\n";
+  } else if (truncated.Valid() || missing.Valid() || corrupt_valid != 0) {
+    cout << "failed" << "\n";
+    cout << "\n" << "Truncated, missing or corrupt files should not be valid, " << corrupt_valid
+         << " corrupt headers were" << "\n";
+    cout << "\n";
+  } else {
+    cout << "passed" << "\n";
+  }
+  return;
+}
+
+void TestBitSearchContext() {
+  cout << "----------------------------------------------------------" << "\n";
+  cout << "BitSearchContext Test: ";
+  std::unique_ptr<BitGrid> bits;
+  std::unique_ptr<BitSearchContext> bit_context;
+  // 70 columns so rows straddle two words.
+  int failures = CompareOnRandomBoards(24, 70, 40,
+      [&](Grid &board, unsigned, std::mt19937 &) {
+        bit_context.reset();
+        bits.reset(new BitGrid(board));
+        bit_context.reset(new BitSearchContext(*bits));
+      },
+      [&](const Grid &board, int init[2], int goal[2], const vector<Point> &shortest, std::ostream &why) {
+        auto bit_path = bit_context->Search(init, goal);
+        why << "BitSearchContext path: ";
+        PrintPath(bit_path, why);
+        why << "Correct length: " << shortest.size() << "\n";
+        return bit_path.size() == shortest.size() && (bit_path.empty() || CheckPath(bit_path, init, goal, board));
+      });
+  Grid board = GenerateRandomBoard(24, 64, 20, 1);
+  BitGrid obstacles(board);
+  size_t grid_bytes = board.Size() * sizeof(State);
+  if (failures == 0 && obstacles.Bytes() * 32 != grid_bytes) {
+    cout << "failed" << "\n";
+    cout << "\n" << "BitGrid uses " << obstacles.Bytes() << " bytes for a board a Grid stores in " << grid_bytes << "\n";
+    cout << "Correct result: " << grid_bytes / 32 << "\n";
+    cout << "\n";
+    failures++;
+  }
+  if (failures == 0)
+    cout << "passed" << "\n";
+  return;
+}
+
+void TestDStarLite() {
+  cout << "----------------------------------------------------------" << "\n";
+  cout << "DStarLite Test: ";
+  int failures = 0;
+  long first_expansions = 0;
+  long replan_expansions = 0;
+  int replans = 0;
+  for (unsigned seed = 1; seed <= 20 && failures == 0; seed++) {
+    Grid board = GenerateRandomBoard(30, 40, seed % 4 * 10, seed);
+    std::mt19937 rng(seed);
+    Point start{int(rng() % 30), int(rng() % 40)};
+    Point goal{int(rng() % 30), int(rng() % 40)};
+    board(start.x, start.y) = State::kEmpty;
+    board(goal.x, goal.y) = State::kEmpty;
+    DStarLite planner(board, start, goal);
+    for (int step = 0; step < 15 && failures == 0; step++) {
+      auto path = planner.Plan();
+      if (step == 0) {
+        first_expansions += planner.Expansions();
+      } else {
+        replan_expansions += planner.Expansions();
+        replans++;
+      }
+      SearchContext context(planner.Board());
+      auto solution = context.Search(start, goal);
+      int init[2]{start.x, start.y};
+      int target[2]{goal.x, goal.y};
+      if (path.size() != solution.size() || (!path.empty() && !CheckPath(path, init, target, planner.Board()))) {
+        cout << "failed" << "\n";
+        cout << "\n" << "Board seed " << seed << ", step " << step << ", plan from (" << start.x << ", " << start.y
+             << ") to (" << goal.x << ", " << goal.y << ")" << "\n";
+        cout << "DStarLite path: ";
+        PrintPath(path);
+        cout << "Correct length: " << solution.size() << "\n";
+        cout << "\n";
+        failures++;
+        break;
+      }
+      // Walk a step along the path, then flip a few cells.
+      if (path.size() > 1) {
+        start = path[1];
+        planner.MoveStart(start);
+      }
+      vector<CellChange> changes{};
+      for (int k = 0; k < 3; k++) {
+        Point c{int(rng() % 30), int(rng() % 40)};
+        if (c == start || c == goal)
+          continue;
+        bool obstacle = planner.Board()(c.x, c.y) == State::kObstacle;
+        changes.push_back(CellChange{c, obstacle ? State::kEmpty : State::kObstacle});
+      }
+      planner.ChangeCells(changes);
+    }
+  }
+  if (failures == 0 && replan_expansions / replans * 2 > first_expansions / 20) {
+    cout << "failed" << "\n";
+    cout << "\n" << "Average expansions: first plan " << first_expansions / 20 << ", replan "
+         << replan_expansions / replans << "\n";
+    cout << "Replanning should take less than half the work of the first plan" << "\n";
+    cout << "\n";
+    failures++;
+  }
+  if (failures == 0)
+    cout << "passed" << "\n";
+  return;
+}
+
+// Plain Dijkstra on a cost board, the cost of the cheapest path or -1.
+int ReferenceCost(const CostGrid &board, int init[2], int goal[2]) {
+  if (board(init[0], init[1]) == 0 || board(goal[0], goal[1]) == 0)
+    return -1;
+  vector<int> dist(board.Size(), -1);
+  std::priority_queue<std::pair<int, int>, vector<std::pair<int, int>>, std::greater<std::pair<int, int>>> queue;
+  queue.push({0, board.Index(init[0], init[1])});
+  while (!queue.empty()) {
+    auto [d, i] = queue.top();
+    queue.pop();
+    if (dist[i] != -1)
+      continue;
+    dist[i] = d;
+    for (int k = 0; k < 4; k++) {
+      int x2 = i / board.Width() + delta[k][0];
+      int y2 = i % board.Width() + delta[k][1];
+      if (x2 >= 0 && x2 < board.Height() && y2 >= 0 && y2 < board.Width() && board(x2, y2) != 0)
+        queue.push({d + board(x2, y2), board.Index(x2, y2)});
+    }
+  }
+  return dist[board.Index(goal[0], goal[1])];
+}
+
+void TestWeightedSearch() {
+  cout << "----------------------------------------------------------" << "\n";
+  cout << "WeightedSearchContext Test: ";
+  std::unique_ptr<CostGrid> costs;
+  std::unique_ptr<WeightedSearchContext<SearchStats>> context;
+  int failures = CompareOnRandomBoards(24, 32, 40,
+      [&](Grid &board, unsigned seed, std::mt19937 &rng) {
+        context.reset();
+        costs.reset(new CostGrid(board));
+        // Every other board gets random costs, the rest keep unit costs.
+        for (int i = 0; i < costs->Size() && seed % 2 == 0; i++)
+          if ((*costs)(i / 32, i % 32) != 0)
+            (*costs)(i / 32, i % 32) = 1 + rng() % (seed % 3 == 0 ? 255 : 9);
+        context.reset(new WeightedSearchContext<SearchStats>(*costs));
+      },
+      [&](const Grid &board, int init[2], int goal[2], const vector<Point> &, std::ostream &why) {
+        auto path = context->Search(init, goal);
+        int cost = path.empty() ? -1 : context->PathCost(path);
+        int solution = ReferenceCost(*costs, init, goal);
+        const SearchStats &stats = context->LastStats();
+        why << "Path cost: " << cost << "\n";
+        why << "Correct cost: " << solution << "\n";
+        why << "Expanded: " << stats.expanded << ", pushed: " << stats.pushed << "\n";
+        // Every cell on a path found was expanded, and nothing is expanded unpushed.
+        bool counted = stats.queries == 1 && stats.pushed >= stats.expanded &&
+                       stats.expanded >= (long long)path.size();
+        return cost == solution && counted && (path.empty() || CheckPath(path, init, goal, board));
+      });
+
+  std::ofstream out("files/test.board");
+  out << "1,2,0,\n" << "3,255,300,\n" << "-4,7,\n";
+  out.close();
+  CostGrid loaded = ReadCostBoardFile("files/test.board");
+  std::remove("files/test.board");
+  vector<uint8_t> solution{1, 2, 0, 3, 255, 255, 0, 7, 0};
+  if (failures == 0 && loaded.Costs() != solution) {
+    cout << "failed" << "\n";
+    cout << "\n" << "ReadCostBoardFile gave the wrong costs" << "\n";
+    cout << "\n";
+    failures++;
+  }
+  if (failures == 0)
+    cout << "passed" << "\n";
+  return;
+}
+
+// Cost of path under Neighborhood's moves, or -1 if it isn't a legal path.
+template <typename Neighborhood>
+int NeighborhoodPathCost(const vector<Point> &path, const Grid &grid) {
+  auto open = [&](int x, int y) {
+    return x >= 0 && x < grid.Height() && y >= 0 && y < grid.Width() && grid(x, y) != State::kObstacle;
+  };
+  int cost = 0;
+  for (size_t i = 1; i < path.size(); i++) {
+    int dx = path[i].x - path[i - 1].x;
+    int dy = path[i].y - path[i - 1].y;
+    int d = 0;
+    while (d < Neighborhood::kDirections && (Neighborhood::kDelta[d][0] != dx || Neighborhood::kDelta[d][1] != dy))
+      d++;
+    if (d == Neighborhood::kDirections || !open(path[i].x, path[i].y))
+      return -1;
+    if (!Neighborhood::kCutCorners && dx != 0 && dy != 0 &&
+        (!open(path[i - 1].x + dx, path[i - 1].y) || !open(path[i - 1].x, path[i - 1].y + dy)))
+      return -1;
+    cost += Neighborhood::kCost[d];
+  }
+  return cost;
+}
+
+// Plain Dijkstra under Neighborhood's moves, the cost of the cheapest path or -1.
+template <typename Neighborhood>
+int ReferenceNeighborhoodCost(const Grid &grid, int init[2], int goal[2]) {
+  auto open = [&](int x, int y) {
+    return x >= 0 && x < grid.Height() && y >= 0 && y < grid.Width() && grid(x, y) != State::kObstacle;
+  };
+  if (!open(init[0], init[1]) || !open(goal[0], goal[1]))
+    return -1;
+  vector<int> dist(grid.Size(), -1);
+  std::priority_queue<std::pair<int, int>, vector<std::pair<int, int>>, std::greater<std::pair<int, int>>> queue;
+  queue.push({0, grid.Index(init[0], init[1])});
+  while (!queue.empty()) {
+    auto [d, i] = queue.top();
+    queue.pop();
+    if (dist[i] != -1)
+      continue;
+    dist[i] = d;
+    int x = i / grid.Width();
+    int y = i % grid.Width();
+    for (int k = 0; k < Neighborhood::kDirections; k++) {
+      int dx = Neighborhood::kDelta[k][0];
+      int dy = Neighborhood::kDelta[k][1];
+      if (!open(x + dx, y + dy))
+        continue;
+      if (!Neighborhood::kCutCorners && dx != 0 && dy != 0 && (!open(x + dx, y) || !open(x, y + dy)))
+        continue;
+      queue.push({d + Neighborhood::kCost[k], grid.Index(x + dx, y + dy)});
+    }
+  }
+  return dist[grid.Index(goal[0], goal[1])];
+}
+
+// Compare BasicSearchContext<Neighborhood> with the reference on random boards.
+template <typename Neighborhood>
+int CheckNeighborhood(const string &name) {
+  for (unsigned seed = 1; seed <= 30; seed++) {
+    Grid board = GenerateRandomBoard(24, 32, seed % 4 * 10, seed);
+    BasicSearchContext<Neighborhood> context(board);
+    std::mt19937 rng(seed);
+    for (int q = 0; q < 25; q++) {
+      int init[2]{int(rng() % 24), int(rng() % 32)};
+      int goal[2]{int(rng() % 24), int(rng() % 32)};
+      auto path = context.Search(init, goal);
+      int cost = path.empty() ? -1 : NeighborhoodPathCost<Neighborhood>(path, board);
+      int solution = ReferenceNeighborhoodCost<Neighborhood>(board, init, goal);
+      bool ends_ok = path.empty() || (path.front() == Point{init[0], init[1]} && path.back() == Point{goal[0], goal[1]});
+      if (cost != solution || !ends_ok) {
+        cout << "failed" << "\n";
+        cout << "\n" << name << ", board seed " << seed << ", query (" << init[0] << ", " << init[1] << ") to ("
+             << goal[0] << ", " << goal[1] << ")" << "\n";
+        cout << "Path cost: " << cost << "\n";
+        cout << "Correct cost: " << solution << "\n";
+        cout << "\n";
+        return 1;
+      }
+    }
+  }
+  return 0;
+}
+
+void TestNeighborhoods() {
+  cout << "----------------------------------------------------------" << "\n";
+  cout << "Neighborhoods Test: ";
+  int failures = CheckNeighborhood<FourConnected>("FourConnected");
+  if (failures == 0)
+    failures += CheckNeighborhood<EightConnected>("EightConnected");
+  if (failures == 0)
+    failures += CheckNeighborhood<EightConnectedNoCorners>("EightConnectedNoCorners");
+
+  // A gap between two diagonal obstacles: only corner cutting goes through.
+  Grid board(2, 2);
+  board(0, 1) = State::kObstacle;
+  board(1, 0) = State::kObstacle;
+  int init[2]{0, 0};
+  int goal[2]{1, 1};
+  auto cut = BasicSearchContext<EightConnected>(board).Search(init, goal);
+  auto no_cut = BasicSearchContext<EightConnectedNoCorners>(board).Search(init, goal);
+  if (failures == 0 && (cut.size() != 2 || !no_cut.empty())) {
+    cout << "failed" << "\n";
+    cout << "\n" << "Corner cutting: path lengths " << cut.size() << " and " << no_cut.size()
+         << ", expected 2 and 0" << "\n";
+    cout << "\n";
+    failures++;
+  }
+  if (failures == 0)
+    cout << "passed" << "\n";
+  return;
+}
+
+void TestLandmarks() {
+  cout << "----------------------------------------------------------" << "\n";
+  cout << "Landmarks Test: ";
+  std::unique_ptr<Landmarks> table;
+  std::unique_ptr<LandmarkSearchContext<>> landmark_context;
+  int failures = CompareOnRandomBoards(24, 32, 20,
+      [&](Grid &board, unsigned seed, std::mt19937 &) {
+        landmark_context.reset();
+        table.reset(new Landmarks(board, 1 + seed % 8));
+        landmark_context.reset(new LandmarkSearchContext<>(board, *table));
+      },
+      [&](const Grid &board, int init[2], int goal[2], const vector<Point> &shortest, std::ostream &why) {
+        // Landmarks are just the heuristic, so jump points work with them too.
+        auto path = landmark_context->Search(init, goal);
+        auto jps_path = landmark_context->Search(init, goal, Expansion::kJumpPoints);
+        why << "Path length: " << path.size() << ", with jump points: " << jps_path.size() << "\n";
+        why << "Correct length: " << shortest.size() << "\n";
+        return path.size() == shortest.size() && jps_path.size() == shortest.size() &&
+               (path.empty() || (CheckPath(path, init, goal, board) && CheckPath(jps_path, init, goal, board)));
+      });
+
+  // A wall with a gap at the far end: Manhattan distance points straight
+  // through it, so plain A* floods the whole near side.
+  Grid board(60, 60);
+  for (int y = 0; y < 59; y++)
+    board(30, y) = State::kObstacle;
+  Landmarks none(board, 0);
+  Landmarks landmarks(board, 8);
+  LandmarkSearchContext<SearchStats> plain(board, none);
+  LandmarkSearchContext<SearchStats> alt(board, landmarks);
+  int init[2]{20, 10};
+  int goal[2]{40, 10};
+  auto plain_path = plain.Search(init, goal);
+  auto alt_path = alt.Search(init, goal);
+  long long alt_expanded = alt.LastStats().expanded;
+  long long plain_expanded = plain.LastStats().expanded;
+  if (failures == 0 && (alt_path.size() != plain_path.size() || alt_expanded * 4 > plain_expanded)) {
+    cout << "failed" << "\n";
+    cout << "\n" << "Wall board: " << alt_expanded << " expansions with landmarks, "
+         << plain_expanded << " without" << "\n";
+    cout << "\n";
+    failures++;
+  }
+
+  // A serpentine longer than 16-bit distances: the landmark's distances
+  // saturate instead of dropping out, so the heuristic stays consistent.
+  Grid snake(261, 512);
+  for (int x = 1; x < snake.Height(); x += 2)
+    for (int y = 0; y < snake.Width(); y++)
+      if (y != (x % 4 == 1 ? snake.Width() - 1 : 0))
+        snake(x, y) = State::kObstacle;
+  Landmarks far(snake, vector<Point>{Point{0, 0}}, 1);
+  int end = snake.Index(snake.Height() - 1, snake.Width() - 1);
+  bool consistent = far.At(end)[0] == Landmarks::kSaturated;
+  for (int x = 0; x < snake.Height() && consistent; x += 2)
+    for (int y = 1; y < snake.Width(); y++)
+      consistent = consistent && std::abs(far.Heuristic(x, y, 0, 0) - far.Heuristic(x, y - 1, 0, 0)) <= 1;
+  if (failures == 0 && !consistent) {
+    cout << "failed" << "\n";
+    cout << "\n" << "Landmark distance past 65534 steps is " << far.At(end)[0] << "\n";
+    cout << "\n";
+    failures++;
+  }
+  if (failures == 0)
+    cout << "passed" << "\n";
+  return;
+}
+
+void TestBoardRenderer() {
+  cout << "----------------------------------------------------------" << "\n";
+  cout << "BoardRenderer Test: ";
+  int init[2]{0, 0};
+  int goal[2]{4, 5};
+  Grid board = Search(ReadBoardFile("files/1.board"), init, goal);
+  string solution{};
+  for (int x = 0; x < board.Height(); x++) {
+    for (int y = 0; y < board.Width(); y++)
+      solution += CellString(board(x, y));
+    solution += "\n";
+  }
+  BoardRenderer renderer;
+  std::ostringstream frame;
+  renderer.Render(board, frame);
+
+  std::ostringstream first;
+  std::ostringstream unchanged;
+  std::ostringstream changed;
+  int first_cells = renderer.RenderDiff(board, first);
+  int unchanged_cells = renderer.RenderDiff(board, unchanged);
+  board(2, 3) = State::kObstacle;
+  board(2, 4) = State::kObstacle;
+  int changed_cells = renderer.RenderDiff(board, changed);
+  string changed_solution = "\x1b[3;16H" + CellString(State::kObstacle) + CellString(State::kObstacle) + "\x1b[6;1H";
+
+  if (frame.str() != solution) {
+    cout << "failed" << "\n";
+    cout << "\n" << "Render gave:" << "\n" << frame.str();
+    cout << "Correct frame:" << "\n" << solution;
+    cout << "\n";
+  } else if (first_cells != board.Size() || first.str() != "\x1b[H\x1b[2J" + solution || unchanged_cells != 0 ||
+             !unchanged.str().empty() || changed_cells != 2 || changed.str() != changed_solution) {
+    cout << "failed" << "\n";
+    cout << "\n" << "RenderDiff wrote " << first_cells << ", " << unchanged_cells << " and " << changed_cells
+         << " cells" << "\n";
+    cout << "Correct counts: " << board.Size() << ", 0 and 2" << "\n";
+    cout << "\n";
+  } else {
+    cout << "passed" << "\n";
+  }
+  return;
+}
+
+// Number of open cells reachable from the first open cell, and in all.
+std::pair<int, int> CountReachable(const Grid &board) {
+  int open = 0;
+  int first = -1;
+  for (int i = 0; i < board.Size(); i++) {
+    if (board(i / board.Width(), i % board.Width()) != State::kObstacle) {
+      open++;
+      if (first == -1)
+        first = i;
+    }
+  }
+  if (first == -1)
+    return {0, 0};
+  vector<bool> seen(board.Size(), false);
+  vector<int> queue{first};
+  seen[first] = true;
+  for (size_t head = 0; head < queue.size(); head++) {
+    int x = queue[head] / board.Width();
+    int y = queue[head] % board.Width();
+    for (int d = 0; d < 4; d++) {
+      int x2 = x + delta[d][0];
+      int y2 = y + delta[d][1];
+      if (CheckValidCell(x2, y2, board) && !seen[board.Index(x2, y2)]) {
+        seen[board.Index(x2, y2)] = true;
+        queue.push_back(board.Index(x2, y2));
+      }
+    }
+  }
+  return {int(queue.size()), open};
+}
+
+void TestBoardGenerators() {
+  cout << "----------------------------------------------------------" << "\n";
+  cout << "Board Generators Test: ";
+  int failures = 0;
+  for (unsigned seed = 1; seed <= 10 && failures == 0; seed++) {
+    int h = 20 + seed;
+    int w = 31 + 2 * seed;
+    Grid maze = GenerateMaze(h, w, seed);
+    Grid rooms = GenerateRooms(h, w, 1 + seed % 6, seed);
+    Grid random = GenerateRandomBoard(h, w, 30, seed);
+    auto maze_reach = CountReachable(maze);
+    auto rooms_reach = CountReachable(rooms);
+    // A perfect maze is a tree: one corridor cell per room but the first.
+    int maze_rooms = ((h + 1) / 2) * ((w + 1) / 2);
+    bool same = maze == GenerateMaze(h, w, seed) && rooms == GenerateRooms(h, w, 1 + seed % 6, seed) &&
+                random == GenerateBoard("random30", h, w, seed) && GenerateBoard("open", h, w, seed) == Grid(h, w);
+    if (!same || maze_reach.first != maze_reach.second || maze_reach.second != 2 * maze_rooms - 1 ||
+        rooms_reach.first != rooms_reach.second) {
+      cout << "failed" << "\n";
+      cout << "\n" << "Seed " << seed << ": deterministic " << same << ", maze reaches " << maze_reach.first
+           << " of " << maze_reach.second << " cells (should be " << 2 * maze_rooms - 1 << "), rooms reach "
+           << rooms_reach.first << " of " << rooms_reach.second << "\n";
+      cout << "\n";
+      failures++;
+    }
+  }
+  if (failures == 0 && !GenerateBoard("random1x", 4, 4, 1).Empty()) {
+    cout << "failed" << "\n";
+    cout << "\n" << "GenerateBoard accepted an unknown kind" << "\n";
+    cout << "\n";
+    failures++;
+  }
+  if (failures == 0)
+    cout << "passed" << "\n";
+  return;
+}
+
+void TestSearchStats() {
   cout << "----------------------------------------------------------" << "\n";
+  cout << "SearchStats Test: ";
+  int failures = 0;
+  Grid board = GenerateRandomBoard(24, 32, 30, 7);
+  SearchContext plain(board);
+  BasicSearchContext<FourConnected, SearchStats> counted(board);
+  SearchStats total{};
+  std::mt19937 rng(7);
+  for (int q = 0; q < 50 && failures == 0; q++) {
+    int init[2]{int(rng() % 24), int(rng() % 32)};
+    int goal[2]{int(rng() % 24), int(rng() % 32)};
+    Expansion mode = q % 2 ? Expansion::kJumpPoints : Expansion::kNeighbors;
+    auto path = counted.Search(init, goal, mode);
+    const SearchStats &stats = counted.LastStats();
+    total += stats;
+    bool consistent = stats.queries == 1 && stats.pushed >= stats.expanded &&
+                      stats.heuristic_calls == stats.pushed && stats.duplicate_pushes < std::max(1LL, stats.pushed) &&
+                      stats.peak_open <= size_t(stats.pushed) && stats.seconds >= 0 &&
+                      (path.empty() || stats.expanded >= 1);
+    if (path != plain.Search(init, goal, mode) || !consistent) {
+      cout << "failed" << "\n";
+      cout << "\n" << "Query " << q << ": expanded " << stats.expanded << ", pushed " << stats.pushed
+           << ", duplicates " << stats.duplicate_pushes << ", peak open " << stats.peak_open << ", heuristic calls "
+           << stats.heuristic_calls << "\n";
+      cout << "\n";
+      failures++;
+    }
+  }
+  if (failures == 0 && (total.queries != 50 || total.expanded <= 0)) {
+    cout << "failed" << "\n";
+    cout << "\n" << "Totals over " << total.queries << " queries: expanded " << total.expanded << "\n";
+    cout << "\n";
+    failures++;
+  }
+
+  // Jump Point Search crosses an open board in a few expansions, and the
+  // cells it jumps over are counted as scanned.
+  Grid open_board(64, 64);
+  BasicSearchContext<FourConnected, SearchStats> open_context(open_board);
+  int corner[2]{0, 0};
+  int far_corner[2]{63, 63};
+  open_context.Search(corner, far_corner, Expansion::kJumpPoints);
+  SearchStats jps = open_context.LastStats();
+  open_context.Search(corner, far_corner);
+  SearchStats neighbors = open_context.LastStats();
+  if (failures == 0 && (jps.expanded > 3 || jps.scanned < 126 || neighbors.scanned != 0)) {
+    cout << "failed" << "\n";
+    cout << "\n" << "Open board: JPS expanded " << jps.expanded << " and scanned " << jps.scanned
+         << ", plain A* scanned " << neighbors.scanned << "\n";
+    cout << "Correct result: at most 3, at least 126, 0" << "\n";
+    cout << "\n";
+    failures++;
+  }
+  if (failures == 0)
+    cout << "passed" << "\n";
   return;
-}
\ No newline at end of file
+}
+
+void TestTiledBoard() {
+  cout << "----------------------------------------------------------" << "\n";
+  cout << "TiledBoard Test: ";
+  int failures = 0;
+  Grid board = GenerateRandomBoard(70, 90, 25, 11);
+  // The same board as a board file, converted without a Grid.
+  std::ofstream out("files/test.board");
+  for (int x = 0; x < board.Height(); x++) {
+    for (int y = 0; y < board.Width(); y++)
+      out << (board(x, y) == State::kObstacle ? 1 : 0) << ",";
+    out << "\n";
+  }
+  out.close();
+  bool converted = ConvertBoardFileToTiles("files/test.board", "files/test.tiles", 16);
+  std::remove("files/test.board");
+  bool written = WriteTiledBoard(board, "files/test2.tiles", 64);
+
+  // Room for four 16x16 tiles out of 30.
+  TiledBoard tiles("files/test.tiles", 4 * 16 * 8);
+  TiledBoard big_tiles("files/test2.tiles");
+  for (int x = -1; x <= board.Height() && failures == 0; x++) {
+    for (int y = -1; y <= board.Width() && failures == 0; y++) {
+      bool obstacle = !CheckValidCell(x, y, board);
+      if (!converted || !written || !tiles.Valid() || tiles.Obstacle(x, y) != obstacle ||
+          big_tiles.Obstacle(x, y) != obstacle) {
+        cout << "failed" << "\n";
+        cout << "\n" << "Cell (" << x << ", " << y << ") read back wrong" << "\n";
+        cout << "\n";
+        failures++;
+      }
+    }
+  }
+
+  SearchContext context(board);
+  std::mt19937 rng(11);
+  for (int q = 0; q < 40 && failures == 0; q++) {
+    Point init{int(rng() % 70), int(rng() % 90)};
+    Point goal{int(rng() % 70), int(rng() % 90)};
+    auto path = TiledSearch(tiles, init, goal);
+    auto solution = context.Search(init, goal);
+    int i[2]{init.x, init.y};
+    int g[2]{goal.x, goal.y};
+    if (path.size() != solution.size() || (!path.empty() && !CheckPath(path, i, g, board)) ||
+        tiles.ResidentTiles() > tiles.CacheCapacity()) {
+      cout << "failed" << "\n";
+      cout << "\n" << "Query (" << init.x << ", " << init.y << ") to (" << goal.x << ", " << goal.y << ")" << "\n";
+      cout << "Path length: " << path.size() << ", correct length: " << solution.size() << "\n";
+      cout << "Resident tiles: " << tiles.ResidentTiles() << " of " << tiles.CacheCapacity() << "\n";
+      cout << "\n";
+      failures++;
+    }
+  }
+  std::remove("files/test.tiles");
+  std::remove("files/test2.tiles");
+  if (failures == 0 && (tiles.CacheCapacity() != 4 || tiles.Faults() <= 30 || TiledBoard("files/missing.tiles").Valid())) {
+    cout << "failed" << "\n";
+    cout << "\n" << "Cache of " << tiles.CacheCapacity() << " tiles faulted " << tiles.Faults() << " times" << "\n";
+    cout << "\n";
+    failures++;
+  }
+  if (failures == 0)
+    cout << "passed" << "\n";
+  return;
+}
+
+void TestIdaSearch() {
+  cout << "----------------------------------------------------------" << "\n";
+  cout << "IdaSearchContext Test: ";
+  std::unique_ptr<IdaSearchContext<SearchStats>> ida;
+  int failures = CompareOnRandomBoards(24, 32, 20,
+      [&](Grid &board, unsigned seed, std::mt19937 &) {
+        // Plain IDA* only on small boards, it repeats too much work on big ones.
+        size_t table_entries = seed % 4 == 0 ? 0 : 64 << (seed % 4);
+        if (table_entries == 0)
+          board = GenerateRandomBoard(6, 8, seed % 4 * 10, seed);
+        ida.reset(new IdaSearchContext<SearchStats>(board, table_entries));
+      },
+      [&](const Grid &board, int init[2], int goal[2], const vector<Point> &shortest, std::ostream &why) {
+        auto path = ida->Search(init, goal);
+        why << "Path length: " << path.size() << ", correct length: " << shortest.size() << "\n";
+        why << "Deepest stack: " << ida->LastStats().peak_open << "\n";
+        return path.size() == shortest.size() && (path.empty() || CheckPath(path, init, goal, board)) &&
+               (shortest.empty() || ida->LastStats().peak_open <= shortest.size());
+      });
+  if (failures == 0 && IdaSearchContext<>(Grid(4, 4), 100).Bytes() != 100 * 12) {
+    cout << "failed" << "\n";
+    cout << "\n" << "A table of 100 entries should take 1200 bytes" << "\n";
+    cout << "\n";
+    failures++;
+  }
+  if (failures == 0)
+    cout << "passed" << "\n";
+  return;
+}
+
+void TestSearchNearest() {
+  cout << "----------------------------------------------------------" << "\n";
+  cout << "SearchNearest Test: ";
+  std::unique_ptr<SearchContext> goal_context;
+  std::unique_ptr<SearchContext> nearest_context;
+  std::mt19937 goal_rng;
+  int failures = CompareOnRandomBoards(24, 32, 30,
+      [&](Grid &board, unsigned seed, std::mt19937 &) {
+        goal_context.reset(new SearchContext(board));
+        nearest_context.reset(new SearchContext(board));
+        goal_rng.seed(seed);
+      },
+      [&](const Grid &board, int init[2], int goal[2], const vector<Point> &shortest, std::ostream &why) {
+        // The query's goal and up to 5 more, with the nearest found one search per goal.
+        vector<Point> goals{Point{goal[0], goal[1]}};
+        size_t solution = shortest.size();
+        for (int k = 0, count = goal_rng() % 6; k < count; k++) {
+          goals.push_back(Point{int(goal_rng() % board.Height()), int(goal_rng() % board.Width())});
+          auto path = goal_context->Search(Point{init[0], init[1]}, goals.back());
+          if (!path.empty() && (solution == 0 || path.size() < solution))
+            solution = path.size();
+        }
+        Expansion mode = goal_rng() % 2 ? Expansion::kJumpPoints : Expansion::kNeighbors;
+        auto path = nearest_context->SearchNearest(Point{init[0], init[1]}, goals, mode);
+        bool ends_at_goal = path.empty() || std::find(goals.begin(), goals.end(), path.back()) != goals.end();
+        int end[2]{path.empty() ? 0 : path.back().x, path.empty() ? 0 : path.back().y};
+        why << goals.size() << " goals, path length: " << path.size() << ", correct length: " << solution << "\n";
+        return path.size() == solution && ends_at_goal && (path.empty() || CheckPath(path, init, end, board));
+      });
+  Grid open_board(3, 3);
+  SearchContext context(open_board);
+  if (failures == 0 && !context.SearchNearest(Point{0, 0}, vector<Point>{}).empty()) {
+    cout << "failed" << "\n";
+    cout << "\n" << "SearchNearest with no goals should find nothing" << "\n";
+    cout << "\n";
+    failures++;
+  }
+  // A repeated goal counts once, and a query's goals don't carry over to the next.
+  context.SearchNearest(Point{0, 0}, vector<Point>{Point{0, 1}, Point{0, 1}});
+  auto next = context.SearchNearest(Point{0, 0}, vector<Point>{Point{2, 2}});
+  if (failures == 0 && (next.size() != 5 || next.back() != Point{2, 2})) {
+    cout << "failed" << "\n";
+    cout << "\n" << "SearchNearest stopped at a goal of the previous query" << "\n";
+    PrintPath(next);
+    cout << "\n";
+    failures++;
+  }
+  if (failures == 0)
+    cout << "passed" << "\n";
+  return;
+}
+
+void TestPathCache() {
+  cout << "----------------------------------------------------------" << "\n";
+  cout << "PathCache Test: ";
+  int failures = 0;
+  Grid board = GenerateRandomBoard(24, 32, 20, 5);
+  SearchContext context(board);
+  PathCache cache(board);
+  vector<Query> queries{};
+  std::mt19937 rng(5);
+  for (int q = 0; q < 30; q++)
+    queries.push_back(Query{Point{int(rng() % 24), int(rng() % 32)}, Point{int(rng() % 24), int(rng() % 32)}});
+
+  // Every query twice: 30 misses, then 30 hits giving the same paths.
+  for (int round = 0; round < 2 && failures == 0; round++) {
+    for (auto &query : queries) {
+      if (cache.Search(context, query.init, query.goal) != context.Search(query.init, query.goal)) {
+        cout << "failed" << "\n";
+        cout << "\n" << "Cached path differs in round " << round << "\n";
+        cout << "\n";
+        failures++;
+        break;
+      }
+    }
+  }
+  PathCacheStats stats = cache.Stats();
+  if (failures == 0 && (stats.hits != 30 || stats.misses != 30 || stats.entries != 30)) {
+    cout << "failed" << "\n";
+    cout << "\n" << "Hits " << stats.hits << ", misses " << stats.misses << ", entries " << stats.entries
+         << ", expected 30, 30 and 30" << "\n";
+    cout << "\n";
+    failures++;
+  }
+
+  // Reading cells doesn't touch the cache. Editing one, even by writing
+  // through board(x, y), empties it, the new path avoids the edit, and a
+  // path found before the edit isn't stored.
+  Query edited = queries[0];
+  for (auto &query : queries)
+    if (context.Search(query.init, query.goal).size() > 2)
+      edited = query;
+  auto old_path = cache.Search(context, edited.init, edited.goal);
+  uint64_t old_revision = board.Revision();
+  int open_cells = 0;
+  for (int x = 0; x < board.Height(); x++)
+    for (int y = 0; y < board.Width(); y++)
+      open_cells += board(x, y) == State::kEmpty;
+  bool read_kept = cache.Stats().entries == 30 && board.Revision() == old_revision && open_cells > 0;
+  if (old_path.size() > 2)
+    board(old_path[1].x, old_path[1].y) = State::kObstacle;
+  auto new_path = cache.Search(context, edited.init, edited.goal);
+  Query other = edited.init == queries[0].init ? queries[1] : queries[0];
+  cache.Insert(other.init, other.goal, vector<Point>{}, old_revision);
+  vector<Point> found{};
+  bool stale_stored = cache.Find(other.init, other.goal, found);
+  stats = cache.Stats();
+  if (failures == 0 && (old_path.size() <= 2 || !read_kept || stale_stored || stats.invalidations != 1 ||
+                        stats.entries != 1 || new_path == old_path ||
+                        new_path != context.Search(edited.init, edited.goal))) {
+    cout << "failed" << "\n";
+    cout << "\n" << "Edit gave " << stats.invalidations << " invalidations and " << stats.entries << " entries"
+         << "\n";
+    cout << "\n";
+    failures++;
+  }
+
+  // A copy carries the revision of its source, a Grid moved from is left
+  // empty with its revision moved on.
+  Grid copy = board;
+  uint64_t copied_revision = copy.Revision();
+  Grid moved = std::move(copy);
+  if (failures == 0 && (copied_revision != board.Revision() || moved.Revision() != copied_revision ||
+                        moved != board || !copy.Empty() || copy.Revision() == copied_revision)) {
+    cout << "failed" << "\n";
+    cout << "\n" << "Revisions: board " << board.Revision() << ", copy " << copied_revision << ", moved to "
+         << moved.Revision() << ", moved from " << copy.Revision() << "\n";
+    cout << "\n";
+    failures++;
+  }
+
+  // A small budget keeps evicting, and many threads share one cache.
+  PathCache small_cache(board, 2000);
+  vector<vector<Point>> results(8 * queries.size());
+  vector<std::thread> threads;
+  for (int t = 0; t < 8; t++) {
+    threads.emplace_back([&, t]() {
+      SearchContext own(board);
+      for (size_t q = 0; q < queries.size(); q++)
+        results[t * queries.size() + q] = small_cache.Search(own, queries[(q + t) % queries.size()].init,
+                                                             queries[(q + t) % queries.size()].goal);
+    });
+  }
+  for (auto &t : threads)
+    t.join();
+  stats = small_cache.Stats();
+  for (int t = 0; t < 8 && failures == 0; t++) {
+    for (size_t q = 0; q < queries.size(); q++) {
+      auto &query = queries[(q + t) % queries.size()];
+      if (results[t * queries.size() + q] != context.Search(query.init, query.goal) || stats.bytes > 2000 ||
+          stats.evictions == 0 || stats.hits + stats.misses != 8 * 30) {
+        cout << "failed" << "\n";
+        cout << "\n" << "Shared cache: " << stats.hits << " hits, " << stats.misses << " misses, "
+             << stats.evictions << " evictions, " << stats.bytes << " bytes" << "\n";
+        cout << "\n";
+        failures++;
+        break;
+      }
+    }
+  }
+  if (failures == 0)
+    cout << "passed" << "\n";
+  return;
+}
+// True if map labels board's open cells the same way as fresh labelling.
+bool SameComponents(const ComponentMap &map, const Grid &board) {
+  ComponentMap fresh(board, 1);
+  std::unordered_map<int, int> to_fresh{};
+  std::unordered_map<int, int> from_fresh{};
+  for (int x = 0; x < board.Height(); x++) {
+    for (int y = 0; y < board.Width(); y++) {
+      int a = map.Component(x, y);
+      int b = fresh.Component(x, y);
+      if ((a == -1) != (b == -1) || map.ComponentSize(a) != fresh.ComponentSize(b))
+        return false;
+      if (a == -1)
+        continue;
+      if (to_fresh.emplace(a, b).first->second != b || from_fresh.emplace(b, a).first->second != a)
+        return false;
+    }
+  }
+  return true;
+}
+
+void TestComponents() {
+  cout << "----------------------------------------------------------" << "\n";
+  cout << "Components Test: ";
+  int failures = 0;
+  for (unsigned seed = 1; seed <= 20 && failures == 0; seed++) {
+    Grid board = GenerateRandomBoard(24, 32, seed % 4 * 10 + 20, seed);
+    ComponentMap map(board, seed % 4 + 1);
+    SearchContext context(board);
+    std::mt19937 rng(seed);
+    if (!SameComponents(map, board)) {
+      cout << "failed" << "\n";
+      cout << "\n" << "Labels with " << seed % 4 + 1 << " workers differ from one, seed " << seed << "\n";
+      cout << "\n";
+      failures++;
+      break;
+    }
+    for (int q = 0; q < 25; q++) {
+      Point init{int(rng() % 24), int(rng() % 32)};
+      Point goal{int(rng() % 24), int(rng() % 32)};
+      if (map.Connected(init, goal) == context.Search(init, goal).empty() ||
+          map.Search(context, init, goal) != context.Search(init, goal)) {
+        cout << "failed" << "\n";
+        cout << "\n" << "Connected disagrees with search, seed " << seed << "\n";
+        cout << "\n";
+        failures++;
+        break;
+      }
+    }
+
+    // Open and block cells one at a time, checking the labels after each.
+    for (int edit = 0; edit < 150 && failures == 0; edit++) {
+      int x = rng() % 24;
+      int y = rng() % 32;
+      board(x, y) = board(x, y) == State::kObstacle ? State::kEmpty : State::kObstacle;
+      map.Update(x, y);
+      if (!SameComponents(map, board)) {
+        cout << "failed" << "\n";
+        cout << "\n" << "Labels wrong after edit " << edit << " at (" << x << ", " << y << "), seed " << seed
+             << "\n";
+        cout << "\n";
+        failures++;
+      }
+    }
+  }
+
+  // A wall across row 4 of an open board with a gap at column 0. Closing
+  // the gap splits off rows 0-3, which should cost about that part, not the
+  // whole board; blocking a cell in open space should cost a few cells.
+  Grid board(64, 64);
+  for (int y = 1; y < 64; y++)
+    board.Set(4, y, State::kObstacle);
+  ComponentMap map(board);
+  map.Update(-1, 0);
+  map.Update(64, 70);
+  board.Set(4, 0, State::kObstacle);
+  map.Update(4, 0);
+  int split_cells = map.LastUpdateCells();
+  board.Set(30, 30, State::kObstacle);
+  map.Update(30, 30);
+  int open_cells = map.LastUpdateCells();
+  if (failures == 0 && (!SameComponents(map, board) || split_cells > 4 * 256 || open_cells > 64)) {
+    cout << "failed" << "\n";
+    cout << "\n" << "Blocking visited " << split_cells << " cells to split off 256 and " << open_cells
+         << " in open space" << "\n";
+    cout << "\n";
+    failures++;
+  }
+  if (failures == 0)
+    cout << "passed" << "\n";
+  return;
+}
+
+/**
+ * Check that paths, one cell per step, are legal and never meet: no two
+ * agents on a cell at once, counting agents resting on their goals, and no
+ * two agents swapping cells. Empty paths are agents that weren't planned,
+ * which stay on their starts.
+ */
+bool CheckAgents(const vector<vector<Point>> &paths, const vector<Query> &queries, const Grid &grid) {
+  size_t steps = 0;
+  for (size_t a = 0; a < paths.size(); a++) {
+    auto &path = paths[a];
+    steps = std::max(steps, path.size());
+    if (path.empty())
+      continue;
+    if (path.front() != queries[a].init || path.back() != queries[a].goal)
+      return false;
+    for (size_t t = 0; t < path.size(); t++)
+      if (!CheckValidCell(path[t].x, path[t].y, grid) ||
+          (t > 0 && Heuristic(path[t - 1].x, path[t - 1].y, path[t].x, path[t].y) > 1))
+        return false;
+  }
+  auto at = [&](size_t a, size_t t) {
+    return paths[a].empty() ? queries[a].init : paths[a][std::min(t, paths[a].size() - 1)];
+  };
+  for (size_t t = 0; t < std::max<size_t>(steps, 1); t++) {
+    for (size_t a = 0; a < paths.size(); a++) {
+      for (size_t b = a + 1; b < paths.size(); b++) {
+        if (at(a, t) == at(b, t) || (t > 0 && at(a, t) == at(b, t - 1) && at(b, t) == at(a, t - 1)))
+          return false;
+      }
+    }
+  }
+  return true;
+}
+
+void TestCooperativePlanner() {
+  cout << "----------------------------------------------------------" << "\n";
+  cout << "Cooperative Planner Test: ";
+  int failures = 0;
+
+  // Alone on the board an agent takes a shortest path.
+  Grid board = GenerateRandomBoard(24, 32, 20, 3);
+  SearchContext context(board);
+  CooperativePlanner single(board);
+  std::mt19937 rng(3);
+  for (int q = 0; q < 25 && failures == 0; q++) {
+    Point init{int(rng() % 24), int(rng() % 32)};
+    Point goal{int(rng() % 24), int(rng() % 32)};
+    single.Clear();
+    if (single.Plan(init, goal).size() != context.Search(init, goal).size()) {
+      cout << "failed" << "\n";
+      cout << "\n" << "Lone agent path differs from Search, query " << q << "\n";
+      cout << "\n";
+      failures++;
+    }
+  }
+
+  // Two agents head on in a corridor with one side pocket: one has to step
+  // aside and wait, and the planned paths must not meet.
+  Grid corridor(3, 9);
+  for (int y = 0; y < 9; y++) {
+    corridor(0, y) = State::kObstacle;
+    corridor(2, y) = State::kObstacle;
+  }
+  corridor(2, 6) = State::kEmpty;
+  CooperativePlanner planner(corridor);
+  vector<Query> head_on{Query{Point{1, 0}, Point{1, 7}}, Query{Point{1, 8}, Point{1, 1}}};
+  auto paths = planner.PlanAll(head_on);
+  if (failures == 0 && (paths[0].empty() || paths[1].empty() || !CheckAgents(paths, head_on, corridor))) {
+    cout << "failed" << "\n";
+    cout << "\n" << "Agents in the corridor collide or weren't planned" << "\n";
+    cout << "\n";
+    failures++;
+  }
+
+  // An agent that can't reach its goal stays in the corridor and blocks it
+  // when it is planned before the agent that needs to pass. Planned after
+  // it, it can't stay without being run over, and Plan reports the clash
+  // instead of parking it.
+  Grid blocked(4, 7);
+  for (int y = 0; y < 7; y++) {
+    blocked(0, y) = State::kObstacle;
+    blocked(2, y) = State::kObstacle;
+    blocked(3, y) = y == 3 ? State::kEmpty : State::kObstacle;
+  }
+  vector<Query> stuck{Query{Point{1, 0}, Point{1, 6}}, Query{Point{1, 3}, Point{3, 3}}};
+  CooperativePlanner one_by_one(blocked);
+  bool stuck_first = one_by_one.Plan(stuck[1].init, stuck[1].goal).empty();
+  bool passed_through = !one_by_one.Plan(stuck[0].init, stuck[0].goal).empty();
+  CooperativePlanner mover_first(blocked);
+  bool moved = !mover_first.Plan(stuck[0].init, stuck[0].goal).empty();
+  bool conflict = false;
+  bool stuck_second = mover_first.Plan(stuck[1].init, stuck[1].goal, &conflict).empty();
+  bool parked_under = mover_first.Reservations().Parked(blocked.Index(stuck[1].init.x, stuck[1].init.y));
+  CooperativePlanner all_at_once(blocked);
+  paths = all_at_once.PlanAll(stuck);
+  if (failures == 0 && (!stuck_first || passed_through || !moved || !stuck_second || !conflict || parked_under ||
+                        !paths[0].empty() || !paths[1].empty() || !CheckAgents(paths, stuck, blocked))) {
+    cout << "failed" << "\n";
+    cout << "\n" << "An agent was planned through one left standing in the corridor" << "\n";
+    cout << "\n";
+    failures++;
+  }
+
+  // Many agents with distinct starts and goals on random boards.
+  for (unsigned seed = 1; seed <= 10 && failures == 0; seed++) {
+    Grid agents_board = GenerateRandomBoard(24, 32, seed % 3 * 10, seed);
+    vector<Point> open{};
+    for (int x = 0; x < 24; x++)
+      for (int y = 0; y < 32; y++)
+        if (agents_board(x, y) == State::kEmpty)
+          open.push_back(Point{x, y});
+    std::mt19937 agents_rng(seed);
+    std::shuffle(open.begin(), open.end(), agents_rng);
+    vector<Point> goals(open.begin(), open.end());
+    std::shuffle(goals.begin(), goals.end(), agents_rng);
+    vector<Query> queries{};
+    for (int a = 0; a < 60; a++)
+      queries.push_back(Query{open[a], goals[a]});
+    CooperativePlanner many(agents_board);
+    paths = many.PlanAll(queries);
+    int planned = 0;
+    for (auto &path : paths)
+      planned += !path.empty();
+    if (!CheckAgents(paths, queries, agents_board) || planned < 45) {
+      cout << "failed" << "\n";
+      cout << "\n" << "Seed " << seed << ": " << planned << " of 60 agents planned" << "\n";
+      cout << "\n";
+      failures++;
+    }
+  }
+  if (failures == 0)
+    cout << "passed" << "\n";
+  cout << "----------------------------------------------------------" << "\n";
+  return;
+}
@@ -0,0 +1,156 @@
+#ifndef PATH_CACHE_H
+#define PATH_CACHE_H
+
+#include <cstdint>
+#include <iterator>  // for prev
+#include <list>
+#include <mutex>
+#include <unordered_map>
+#include "astar.h"
+
+
+// Counters of a PathCache, copied out under its lock.
+struct PathCacheStats {
+  long long hits = 0;
+  long long misses = 0;
+  long long evictions = 0;
+  long long invalidations = 0;  // times the board changed and the cache was emptied
+  size_t entries = 0;
+  size_t bytes = 0;
+};
+
+
+/**
+ * LRU cache of search results in front of SearchContext, for boards that
+ * change rarely and queries that repeat. Entries are keyed on (board
+ * revision, init, goal): the first lookup after the board's Revision() moves
+ * empties the cache, and a path found on an older revision is never stored,
+ * so edits made with Grid::Set never serve stale paths. Paths are stored in
+ * the PathToDirections encoding, a few bytes per straight run instead of 8
+ * per cell; "no path" results are cached too. Once the stored entries take
+ * more than max_bytes, the least recently used are dropped. Calls are safe
+ * from many threads at once, and the searches themselves run outside the
+ * lock on the caller's own context, but like any search they must not
+ * overlap an edit of the board.
+ */
+class PathCache {
+  public:
+    PathCache(const Grid &board, size_t max_bytes = size_t(1) << 20)
+        : board(board), max_bytes(max_bytes), revision(board.Revision()) {}
+
+    /**
+     * Cached path from init to goal, or context.Search(init, goal) stored for
+     * next time. context must search the same board as the cache.
+     */
+    std::vector<Point> Search(SearchContext &context, Point init, Point goal) {
+      std::vector<Point> path{};
+      if (Find(init, goal, path))
+        return path;
+      uint64_t searched = board.Revision();
+      path = context.Search(init, goal);
+      Insert(init, goal, path, searched);
+      return path;
+    }
+
+    // Look up init to goal. Returns false on a miss.
+    bool Find(Point init, Point goal, std::vector<Point> &path) {
+      std::lock_guard<std::mutex> lock(mutex);
+      Sync();
+      auto found = index.find(Key{init, goal});
+      if (found == index.end()) {
+        stats.misses++;
+        return false;
+      }
+      stats.hits++;
+      lru.splice(lru.begin(), lru, found->second);
+      const Entry &entry = *found->second;
+      path = entry.found ? DirectionsToPath(init, entry.directions) : std::vector<Point>{};
+      return true;
+    }
+
+    /**
+     * Store the path from init to goal, empty if there is none, as found on
+     * board revision searched. It is dropped if the board has moved on since.
+     */
+    void Insert(Point init, Point goal, const std::vector<Point> &path, uint64_t searched) {
+      std::lock_guard<std::mutex> lock(mutex);
+      Sync();
+      if (searched != revision)
+        return;
+      Key key{init, goal};
+      auto found = index.find(key);
+      if (found != index.end())
+        Erase(found->second);
+      lru.push_front(Entry{key, !path.empty(), PathToDirections(path)});
+      index[key] = lru.begin();
+      stats.entries++;
+      stats.bytes += EntryBytes(lru.front());
+      while (stats.bytes > max_bytes && !lru.empty()) {
+        Erase(std::prev(lru.end()));
+        stats.evictions++;
+      }
+    }
+
+    PathCacheStats Stats() {
+      std::lock_guard<std::mutex> lock(mutex);
+      return stats;
+    }
+
+  private:
+    struct Key {
+      Point init;
+      Point goal;
+
+      bool operator==(const Key &other) const { return init == other.init && goal == other.goal; }
+    };
+
+    struct KeyHash {
+      size_t operator()(const Key &key) const {
+        uint64_t h = 14695981039346656037ull;
+        for (int v : {key.init.x, key.init.y, key.goal.x, key.goal.y})
+          h = (h ^ uint32_t(v)) * 1099511628211ull;
+        return h;
+      }
+    };
+
+    struct Entry {
+      Key key;
+      bool found;
+      std::string directions;
+    };
+
+    const Grid &board;
+    size_t max_bytes;
+    uint64_t revision;
+    std::mutex mutex;
+    std::list<Entry> lru;  // most recently used first
+    std::unordered_map<Key, std::list<Entry>::iterator, KeyHash> index;
+    PathCacheStats stats;
+
+    // Rough heap cost of an entry: list node, index node and string.
+    static size_t EntryBytes(const Entry &entry) {
+      return sizeof(Entry) + 2 * sizeof(void *) + sizeof(Key) + 3 * sizeof(void *) + entry.directions.capacity();
+    }
+
+    // Empty the cache if the board changed since it was filled.
+    void Sync() {
+      if (board.Revision() == revision)
+        return;
+      revision = board.Revision();
+      if (!lru.empty())
+        stats.invalidations++;
+      lru.clear();
+      index.clear();
+      stats.entries = 0;
+      stats.bytes = 0;
+    }
+
+    void Erase(std::list<Entry>::iterator it) {
+      stats.entries--;
+      stats.bytes -= EntryBytes(*it);
+      index.erase(it->key);
+      lru.erase(it);
+    }
+};
+
+#endif
@@ -0,0 +1,118 @@
+#ifndef RENDER_H
+#define RENDER_H
+
+#include <ostream>
+#include <string_view>
+#include "astar.h"
+
+
+/**
+ * Glyph for every State, indexed by the enum's value. Each one is 5 terminal
+ * columns wide, which BoardRenderer relies on to place the cursor.
+ */
+constexpr int kCellColumns = 5;
+
+constexpr std::string_view kCellGlyphs[]{
+  "0    ",    // kEmpty
+  "⛰️    ",   // kObstacle
+  "0    ",    // kClosed
+  "🚗   ",    // kPath
+  "🚦   ",    // kStart
+  "🏁   ",    // kFinish
+};
+
+inline std::string_view CellGlyph(State cell) { return kCellGlyphs[int(cell)]; }
+
+
+inline std::string CellString(State cell) {
+  return std::string(CellGlyph(cell));
+}
+
+
+/**
+ * Draws boards into one reusable buffer and hands each frame to the stream
+ * in a single write, instead of a string and a stream call per cell.
+ * RenderDiff is for live views of a search: the first frame clears the
+ * terminal and draws everything, later frames move the cursor with ANSI
+ * escapes and redraw only the cells that changed since the previous frame.
+ */
+class BoardRenderer {
+  public:
+    // Write the whole board, one line per row.
+    void Render(const Grid &board, std::ostream &out) {
+      buffer.clear();
+      for (int x = 0; x < board.Height(); x++) {
+        for (int y = 0; y < board.Width(); y++)
+          Append(board(x, y));
+        buffer += '\n';
+      }
+      out.write(buffer.data(), buffer.size());
+    }
+
+    /**
+     * Bring a terminal showing the previous frame up to date with board.
+     * Returns the number of cells written. Writes nothing if no cell changed.
+     */
+    int RenderDiff(const Grid &board, std::ostream &out) {
+      buffer.clear();
+      int cells = 0;
+      if (board.Height() != last.Height() || board.Width() != last.Width()) {
+        buffer += "\x1b[H\x1b[2J";
+        for (int x = 0; x < board.Height(); x++) {
+          for (int y = 0; y < board.Width(); y++)
+            Append(board(x, y));
+          buffer += '\n';
+        }
+        cells = board.Size();
+      } else {
+        for (int x = 0; x < board.Height(); x++) {
+          // The cursor is already in place after a run of changed cells.
+          int next = -1;
+          for (int y = 0; y < board.Width(); y++) {
+            if (board(x, y) == last(x, y))
+              continue;
+            if (y != next)
+              MoveCursor(x, y);
+            Append(board(x, y));
+            next = y + 1;
+            cells++;
+          }
+        }
+        if (cells > 0)
+          MoveCursor(board.Height(), 0);
+      }
+      last = board;
+      if (!buffer.empty())
+        out.write(buffer.data(), buffer.size());
+      return cells;
+    }
+
+    // Forget the previous frame, so the next RenderDiff draws everything.
+    void Reset() { last = Grid{}; }
+
+  private:
+    std::string buffer;
+    Grid last;
+
+    void Append(State cell) {
+      std::string_view glyph = CellGlyph(cell);
+      buffer.append(glyph.data(), glyph.size());
+    }
+
+    // ANSI cursor position is 1-based row;column.
+    void MoveCursor(int x, int y) {
+      buffer += "\x1b[";
+      buffer += std::to_string(x + 1);
+      buffer += ';';
+      buffer += std::to_string(y * kCellColumns + 1);
+      buffer += 'H';
+    }
+};
+
+
+inline void PrintBoard(const Grid &board) {
+  BoardRenderer renderer;
+  renderer.Render(board, std::cout);
+}
+
+#endif
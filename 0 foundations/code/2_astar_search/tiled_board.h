@@ -0,0 +1,307 @@
+#ifndef TILED_BOARD_H
+#define TILED_BOARD_H
+
+#include <cstdint>
+#include <cstring>  // for memcpy, memcmp
+#include <fcntl.h>
+#include <fstream>
+#include <list>
+#include <memory>  // for unique_ptr
+#include <unistd.h>
+#include <unordered_map>
+#include "astar.h"
+#include "board_file.h"
+
+
+/**
+ * Tiled board format, version 1, for boards too big to hold in memory.
+ * All values little-endian, which board_file.h checks the host is.
+ *   TiledBoardHeader, padded to 64 bytes
+ *   tiles in row-major order, each tile_size rows of row_words 64-bit words:
+ *   one bit per cell, 1 = obstacle, bit y % 64 of word y / 64 in the row
+ * Every tile has the same size, so tile t starts at data_offset + t * tile
+ * bytes. Cells of edge tiles that fall off the board are obstacles.
+ */
+struct TiledBoardHeader {
+  char magic[4];           // "TIL1"
+  uint32_t version;
+  uint32_t height;
+  uint32_t width;
+  uint32_t tile_size;      // cells along each side of a tile
+  uint32_t tile_rows;
+  uint32_t tile_columns;
+  uint32_t row_words;      // 64-bit words per row of a tile
+  uint64_t data_offset;
+};
+
+const char kTiledBoardMagic[4]{'T', 'I', 'L', '1'};
+const uint32_t kTiledBoardVersion = 1;
+
+
+/**
+ * Writes a tiled board one band of tile_size rows at a time, so only one
+ * band is ever held in memory. Cells are given row by row through Set; rows
+ * and cells that are never set stay obstacles.
+ */
+class TiledBoardWriter {
+  public:
+    TiledBoardWriter(std::string path, int height, int width, int tile_size)
+        : file(path, std::ios::binary), header{}, band_row(0) {
+      std::memcpy(header.magic, kTiledBoardMagic, 4);
+      header.version = kTiledBoardVersion;
+      header.height = height;
+      header.width = width;
+      header.tile_size = tile_size;
+      header.tile_rows = (height + tile_size - 1) / tile_size;
+      header.tile_columns = (width + tile_size - 1) / tile_size;
+      header.row_words = (tile_size + 63) / 64;
+      header.data_offset = AlignTo64(sizeof(header));
+      std::vector<char> padding(header.data_offset - sizeof(header), 0);
+      file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+      file.write(padding.data(), padding.size());
+      band.assign(size_t(header.tile_columns) * tile_size * header.row_words, ~uint64_t(0));
+    }
+
+    // Cell (x, y); x must never go back to an earlier band.
+    void Set(int x, int y, bool obstacle) {
+      while (x >= band_row + int(header.tile_size))
+        FlushBand();
+      int tile_size = header.tile_size;
+      int column = y % tile_size;
+      uint64_t &word = band[(size_t(y / tile_size) * tile_size + (x - band_row)) * header.row_words + column / 64];
+      uint64_t bit = uint64_t(1) << (column % 64);
+      word = obstacle ? word | bit : word & ~bit;
+    }
+
+    // Write the remaining bands. Returns false if any write failed.
+    bool Finish() {
+      while (band_row < int(header.height))
+        FlushBand();
+      file.close();
+      return !file.fail();
+    }
+
+  private:
+    std::ofstream file;
+    TiledBoardHeader header;
+    int band_row;                // first board row of the current band
+    std::vector<uint64_t> band;  // the band's tiles, one after the other
+
+    void FlushBand() {
+      file.write(reinterpret_cast<const char *>(band.data()), band.size() * 8);
+      std::fill(band.begin(), band.end(), ~uint64_t(0));
+      band_row += header.tile_size;
+    }
+};
+
+
+// Write board in the tiled format.
+inline bool WriteTiledBoard(const Grid &board, std::string path, int tile_size = 256) {
+  TiledBoardWriter writer(path, board.Height(), board.Width(), tile_size);
+  for (int x = 0; x < board.Height(); x++)
+    for (int y = 0; y < board.Width(); y++)
+      writer.Set(x, y, board(x, y) == State::kObstacle);
+  return writer.Finish();
+}
+
+
+/**
+ * Convert a board file, as read by ReadBoardFile, to the tiled format
+ * without building a Grid: the file is mapped and tokenized in place and the
+ * cells go straight to a TiledBoardWriter.
+ */
+inline bool ConvertBoardFileToTiles(std::string input, std::string output, int tile_size = 256) {
+  MappedFile file(input);
+  if (!file.Data())
+    return false;
+  std::unique_ptr<TiledBoardWriter> writer;
+  ScanBoardFile(file.Data(), file.Data() + file.Size(),
+                [&](int height, int width) { writer.reset(new TiledBoardWriter(output, height, width, tile_size)); },
+                [&](int x, int y, int value) { writer->Set(x, y, value != 0); });
+  return writer->Finish();
+}
+
+
+/**
+ * A tiled board file read through an LRU cache of tiles. A tile is read
+ * from disk the first time one of its cells is looked at, and the least
+ * recently used tile is dropped once the cache is full, so memory stays
+ * within the cache budget whatever the size of the board.
+ */
+class TiledBoard {
+  public:
+    TiledBoard(std::string path, size_t cache_bytes = size_t(64) << 20)
+        : fd(open(path.c_str(), O_RDONLY)), header{}, capacity(0), faults(0),
+          last_tile(-1), last_bits(nullptr) {
+      if (fd < 0)
+        return;
+      if (pread(fd, &header, sizeof(header), 0) != sizeof(header) ||
+          std::memcmp(header.magic, kTiledBoardMagic, 4) != 0 || header.version != kTiledBoardVersion ||
+          header.tile_size == 0 || header.row_words != (header.tile_size + 63) / 64 ||
+          header.tile_rows != (uint64_t(header.height) + header.tile_size - 1) / header.tile_size ||
+          header.tile_columns != (uint64_t(header.width) + header.tile_size - 1) / header.tile_size) {
+        close(fd);
+        fd = -1;
+        return;
+      }
+      capacity = std::max<size_t>(1, cache_bytes / TileBytes());
+    }
+    ~TiledBoard() {
+      if (fd >= 0)
+        close(fd);
+    }
+    TiledBoard(const TiledBoard &) = delete;
+    TiledBoard &operator=(const TiledBoard &) = delete;
+
+    bool Valid() const { return fd >= 0; }
+    int Height() const { return header.height; }
+    int Width() const { return header.width; }
+    int TileSize() const { return header.tile_size; }
+    size_t TileBytes() const { return size_t(header.tile_size) * header.row_words * 8; }
+
+    // Tiles read from disk so far, and tiles held now.
+    long long Faults() const { return faults; }
+    size_t ResidentTiles() const { return tiles.size(); }
+    size_t CacheCapacity() const { return capacity; }
+
+    // Cells off the board are obstacles.
+    bool Obstacle(int x, int y) {
+      if (x < 0 || x >= Height() || y < 0 || y >= Width())
+        return true;
+      int tile_size = header.tile_size;
+      const uint64_t *bits = Tile(x / tile_size * header.tile_columns + y / tile_size);
+      int column = y % tile_size;
+      return (bits[size_t(x % tile_size) * header.row_words + column / 64] >> (column % 64)) & 1;
+    }
+
+  private:
+    struct CachedTile {
+      std::vector<uint64_t> bits;
+      std::list<int>::iterator use;  // position in lru
+    };
+
+    int fd;
+    TiledBoardHeader header;
+    size_t capacity;
+    long long faults;
+    std::unordered_map<int, CachedTile> tiles;
+    std::list<int> lru;  // tile numbers, most recently used first
+    // Searches mostly stay inside one tile, so skip the lookup for the last one.
+    int last_tile;
+    const uint64_t *last_bits;
+
+    const uint64_t *Tile(int t) {
+      if (t == last_tile)
+        return last_bits;
+      auto found = tiles.find(t);
+      if (found != tiles.end()) {
+        lru.splice(lru.begin(), lru, found->second.use);
+      } else {
+        if (tiles.size() >= capacity) {
+          tiles.erase(lru.back());
+          lru.pop_back();
+        }
+        lru.push_front(t);
+        found = tiles.emplace(t, CachedTile{ReadTile(t), lru.begin()}).first;
+      }
+      last_tile = t;
+      last_bits = found->second.bits.data();
+      return last_bits;
+    }
+
+    // A tile that can't be read is all obstacles.
+    std::vector<uint64_t> ReadTile(int t) {
+      faults++;
+      std::vector<uint64_t> bits(TileBytes() / 8, ~uint64_t(0));
+      off_t offset = header.data_offset + off_t(t) * TileBytes();
+      if (pread(fd, bits.data(), TileBytes(), offset) != ssize_t(TileBytes()))
+        std::fill(bits.begin(), bits.end(), ~uint64_t(0));
+      return bits;
+    }
+};
+
+
+inline bool CheckValidCell(int x, int y, TiledBoard &board) {
+  return !board.Obstacle(x, y);
+}
+
+
+/**
+ * A* on a TiledBoard. Tiles are faulted in as the search reaches them, and
+ * search state is kept per tile too: a tile's g values and parent directions
+ * are only allocated once the search touches it, 5 bytes per cell. A query
+ * costs memory for the area it explores rather than for the whole board.
+ * Returns the cells on a shortest path from init to goal inclusive, or an
+ * empty vector if goal can't be reached.
+ */
+inline std::vector<Point> TiledSearch(TiledBoard &board, Point init, Point goal) {
+  // step is 0 for cells not reached yet, d + 1 for cells entered along
+  // delta[d], and kStart for init. kClosed is or-ed in once expanded.
+  static constexpr uint8_t kStart = 5;
+  static constexpr uint8_t kClosed = 8;
+  struct TileState {
+    std::vector<int> g;
+    std::vector<uint8_t> step;
+  };
+  std::vector<Point> path{};
+  if (!CheckValidCell(init.x, init.y, board) || !CheckValidCell(goal.x, goal.y, board))
+    return path;
+
+  int tile_size = board.TileSize();
+  int tile_columns = (board.Width() + tile_size - 1) / tile_size;
+  std::unordered_map<int, TileState> states;
+  // Search state of cell (x, y), allocating its tile's on first use.
+  auto state = [&](int x, int y, int *&g, uint8_t *&step) {
+    auto found = states.find(x / tile_size * tile_columns + y / tile_size);
+    if (found == states.end()) {
+      size_t cells = size_t(tile_size) * tile_size;
+      found = states.emplace(x / tile_size * tile_columns + y / tile_size,
+                             TileState{std::vector<int>(cells), std::vector<uint8_t>(cells, 0)}).first;
+    }
+    size_t i = size_t(x % tile_size) * tile_size + y % tile_size;
+    g = &found->second.g[i];
+    step = &found->second.step[i];
+  };
+
+  int *g;
+  uint8_t *step;
+  state(init.x, init.y, g, step);
+  *g = 0;
+  *step = kStart;
+  std::vector<Node> open{Node{init.x, init.y, 0, Heuristic(init.x, init.y, goal.x, goal.y)}};
+  while (open.size() > 0) {
+    Node current = PopFromOpen(open);
+    state(current.x, current.y, g, step);
+    if (*step & kClosed)
+      continue;
+    *step |= kClosed;
+
+    if (current.x == goal.x && current.y == goal.y) {
+      path.push_back(goal);
+      for (int s = *step & ~kClosed; s != kStart; s = *step & ~kClosed) {
+        Point p = path.back();
+        path.push_back(Point{p.x - delta[s - 1][0], p.y - delta[s - 1][1]});
+        state(path.back().x, path.back().y, g, step);
+      }
+      std::reverse(path.begin(), path.end());
+      return path;
+    }
+    for (int d = 0; d < 4; d++) {
+      int x2 = current.x + delta[d][0];
+      int y2 = current.y + delta[d][1];
+      if (!CheckValidCell(x2, y2, board))
+        continue;
+      int g2 = current.g + 1;
+      state(x2, y2, g, step);
+      if ((*step & kClosed) || (*step != 0 && *g <= g2))
+        continue;
+      *g = g2;
+      *step = d + 1;
+      open.push_back(Node{x2, y2, g2, Heuristic(x2, y2, goal.x, goal.y)});
+      std::push_heap(open.begin(), open.end(), Compare);
+    }
+  }
+  return path;
+}
+
+#endif
@@ -0,0 +1,252 @@
+#ifndef WEIGHTED_H
+#define WEIGHTED_H
+
+#include <cstdint>
+#include "astar.h"
+#include "board_file.h"
+
+
+/**
+ * Board of traversal costs, one byte per cell: 0 is impassable, 1..255 is
+ * the cost of stepping onto the cell.
+ */
+class CostGrid {
+  public:
+    CostGrid() : height(0), width(0) {}
+    CostGrid(int h, int w, uint8_t fill = 1) : height(h), width(w), costs(size_t(h) * w, fill) {}
+
+    // Obstacles cost 0, every other cell 1.
+    explicit CostGrid(const Grid &board) : CostGrid(board.Height(), board.Width()) {
+      for (int x = 0; x < height; x++)
+        for (int y = 0; y < width; y++)
+          if (board(x, y) == State::kObstacle)
+            (*this)(x, y) = 0;
+    }
+
+    // Cost layer of a binary board, or unit costs around its obstacles.
+    explicit CostGrid(const BinaryBoard &board) : CostGrid(board.Height(), board.Width()) {
+      for (int x = 0; x < height; x++)
+        for (int y = 0; y < width; y++)
+          (*this)(x, y) = board.HasCosts() ? board.Cost(x, y) : board.Obstacle(x, y) ? 0 : 1;
+    }
+
+    int Height() const { return height; }
+    int Width() const { return width; }
+    int Size() const { return costs.size(); }
+    int Index(int x, int y) const { return x * width + y; }
+    const std::vector<uint8_t> &Costs() const { return costs; }
+
+    uint8_t &operator()(int x, int y) { return costs[x * width + y]; }
+    uint8_t operator()(int x, int y) const { return costs[x * width + y]; }
+
+  private:
+    int height;
+    int width;
+    std::vector<uint8_t> costs;
+};
+
+
+/**
+ * Read-only view of costs in the CostGrid layout, either a CostGrid's own or
+ * the cost layer of a mapped BinaryBoard. A BinaryBoard without a cost layer
+ * gives an empty view; load it into a CostGrid for unit costs. Whatever it
+ * views must outlive it.
+ */
+class CostView {
+  public:
+    CostView(const CostGrid &grid) : height(grid.Height()), width(grid.Width()), costs(grid.Costs().data()) {}
+    CostView(const BinaryBoard &board)
+        : height(board.HasCosts() ? board.Height() : 0), width(board.HasCosts() ? board.Width() : 0),
+          costs(board.CostLayer()) {}
+
+    int Height() const { return height; }
+    int Width() const { return width; }
+    int Size() const { return height * width; }
+    int Index(int x, int y) const { return x * width + y; }
+
+    uint8_t operator()(int x, int y) const { return costs[size_t(x) * width + y]; }
+
+    // Cheapest and dearest passable cell, 0 if there are none.
+    uint8_t MinCost() const {
+      uint8_t low = 0;
+      for (int i = 0; i < Size(); i++)
+        if (costs[i] != 0 && (low == 0 || costs[i] < low))
+          low = costs[i];
+      return low;
+    }
+    uint8_t MaxCost() const { return Size() == 0 ? 0 : *std::max_element(costs, costs + Size()); }
+
+  private:
+    int height;
+    int width;
+    const uint8_t *costs;
+};
+
+
+/**
+ * Load a cost board: same comma separated layout as ReadBoardFile, but each
+ * value is the cell's cost, 0 meaning impassable. Values are clamped to
+ * 0..255 and missing cells are impassable.
+ */
+inline CostGrid ReadCostBoardFile(std::string path) {
+  MappedFile file(path);
+  if (!file.Data())
+    return CostGrid{};
+  CostGrid board{};
+  ScanBoardFile(file.Data(), file.Data() + file.Size(),
+                [&](int height, int width) { board = CostGrid(height, width, 0); },
+                [&](int x, int y, int value) { board(x, y) = std::min(std::max(value, 0), 255); });
+  return board;
+}
+
+
+/**
+ * Monotone bucket queue (Dial's algorithm) for small integer keys.
+ * Keys popped never decrease and a pushed key is at most span above the last
+ * key popped, so span + 1 buckets used as a ring are enough. Push is O(1) and
+ * pop is O(1) amortized, with no comparisons between entries.
+ */
+class BucketQueue {
+  public:
+    BucketQueue(int span) : buckets(span + 1), current(-1), count(0) {}
+
+    bool Empty() const { return count == 0; }
+    size_t Size() const { return count; }
+
+    void Clear() {
+      for (auto &b : buckets)
+        b.clear();
+      current = -1;
+      count = 0;
+    }
+
+    // key must be in [last key popped, last key popped + span]. The first key
+    // after Clear can be anything and sets where popping starts.
+    void Push(int key, int item) {
+      if (current < 0)
+        current = key;
+      buckets[key % buckets.size()].push_back(item);
+      count++;
+    }
+
+    // Remove an item with the smallest key, which is stored in key.
+    int Pop(int &key) {
+      while (buckets[current % buckets.size()].empty())
+        current++;
+      auto &bucket = buckets[current % buckets.size()];
+      int item = bucket.back();
+      bucket.pop_back();
+      count--;
+      key = current;
+      return item;
+    }
+
+  private:
+    std::vector<std::vector<int>> buckets;
+    int current;
+    size_t count;
+};
+
+
+/**
+ * A* over a CostView using a BucketQueue keyed on f, so it runs on a CostGrid
+ * or straight on the cost layer of a mapped BinaryBoard.
+ * The heuristic is Manhattan distance times the cheapest cell cost, which
+ * stays admissible and consistent, so f never decreases along the search
+ * and the bucket queue applies. Per-cell state is a SearchScratch as in
+ * BasicSearchContext, and Stats is SearchStats to count what each query
+ * does, see LastStats(). The costs it views must outlive the context.
+ */
+template <typename Stats = NoStats>
+class WeightedSearchContext {
+  public:
+    WeightedSearchContext(CostView board)
+        : board(board), min_cost(std::max<int>(board.MinCost(), 1)),
+          queue(board.MaxCost() + min_cost), scratch(board.Size()) {}
+
+    // Counters for the last call to Search.
+    const Stats &LastStats() const { return stats; }
+
+    // Bytes of per-cell search state, not counting the queue.
+    size_t Bytes() const { return scratch.Bytes(); }
+
+    /**
+     * Find a cheapest path from init to goal, the cost of a path being the sum
+     * of the costs of the cells it steps onto. Returns the cells from init to
+     * goal inclusive, or an empty vector if goal can't be reached.
+     */
+    std::vector<Point> Search(int init[2], int goal[2]) {
+      stats.Begin();
+      std::vector<Point> path = Run(init, goal);
+      stats.End();
+      return path;
+    }
+
+    // Sum of the costs of the cells stepped onto, not counting the first.
+    int PathCost(const std::vector<Point> &path) const {
+      int cost = 0;
+      for (size_t k = 1; k < path.size(); k++)
+        cost += board(path[k].x, path[k].y);
+      return cost;
+    }
+
+  private:
+    CostView board;
+    int min_cost;
+    BucketQueue queue;
+    SearchScratch scratch;
+    Stats stats;
+
+    std::vector<Point> Run(int init[2], int goal[2]) {
+      scratch.NextGeneration();
+      std::vector<Point> path{};
+      if (!Passable(init[0], init[1]) || !Passable(goal[0], goal[1]))
+        return path;
+
+      queue.Clear();
+      Push(board.Index(init[0], init[1]), 0, -1, goal);
+      int w = board.Width();
+      while (!queue.Empty()) {
+        int f;
+        int i = queue.Pop(f);
+        if (scratch.Closed(i))
+          continue;
+        scratch.Close(i);
+        stats.Expand();
+        int x = i / w;
+        int y = i % w;
+        if (x == goal[0] && y == goal[1]) {
+          for (int c = i; c != -1; c = scratch.parent[c])
+            path.push_back(Point{c / w, c % w});
+          std::reverse(path.begin(), path.end());
+          return path;
+        }
+        for (int d = 0; d < 4; d++) {
+          int x2 = x + delta[d][0];
+          int y2 = y + delta[d][1];
+          if (!Passable(x2, y2))
+            continue;
+          int j = board.Index(x2, y2);
+          int g2 = scratch.g_score[i] + board(x2, y2);
+          if (scratch.Improves(j, g2))
+            Push(j, g2, i, goal);
+        }
+      }
+      return path;
+    }
+
+    bool Passable(int x, int y) const {
+      return x >= 0 && x < board.Height() && y >= 0 && y < board.Width() && board(x, y) != 0;
+    }
+
+    void Push(int i, int g, int from, int goal[2]) {
+      int w = board.Width();
+      bool duplicate = scratch.Seen(i);
+      scratch.Record(i, g, from);
+      stats.HeuristicCall();
+      queue.Push(g + min_cost * Heuristic(i / w, i % w, goal[0], goal[1]), i);
+      stats.Push(duplicate, queue.Size());
+    }
+};
+
+#endif